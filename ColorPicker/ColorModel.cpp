@@ -0,0 +1,120 @@
+#include "ColorModel.h"
+
+namespace Custom_Control
+{
+    ColorModel::ColorModel(QObject *parent)
+        : QObject(parent)
+    {
+
+    }
+
+    ColorModel::~ColorModel()
+    {
+
+    }
+
+    void ColorModel::SetHue(int hue)
+    {
+        if (hue < 0 || hue > 359 || hue == m_hue_)
+            return;
+
+        m_hue_ = hue;
+        markChanged(Hue);
+    }
+
+    void ColorModel::SetSaturationValue(int saturation, int value)
+    {
+        saturation = qBound(0, saturation, 255);
+        value = qBound(0, value, 255);
+        if (saturation == m_saturation_ && value == m_value_)
+            return;
+
+        m_saturation_ = saturation;
+        m_value_ = value;
+        markChanged(SaturationValue);
+    }
+
+    void ColorModel::SetAlpha(int alpha)
+    {
+        alpha = qBound(0, alpha, 255);
+        if (alpha == m_alpha_)
+            return;
+
+        m_alpha_ = alpha;
+        markChanged(Alpha);
+    }
+
+    void ColorModel::SetColor(const QColor &color)
+    {
+        if (!color.isValid())
+            return;
+
+        BeginUpdate();
+        // 无彩色的色相为-1，保留当前色相
+        if (color.hsvHue() >= 0)
+            SetHue(color.hsvHue());
+        SetSaturationValue(color.hsvSaturation(), color.value());
+        SetAlpha(color.alpha());
+        CommitUpdate();
+    }
+
+    int ColorModel::Hue() const
+    {
+        return m_hue_;
+    }
+
+    int ColorModel::Saturation() const
+    {
+        return m_saturation_;
+    }
+
+    int ColorModel::Value() const
+    {
+        return m_value_;
+    }
+
+    int ColorModel::Alpha() const
+    {
+        return m_alpha_;
+    }
+
+    QColor ColorModel::Color() const
+    {
+        return QColor::fromHsv(m_hue_, m_saturation_, m_value_, m_alpha_);
+    }
+
+    void ColorModel::BeginUpdate()
+    {
+        ++m_update_depth_;
+    }
+
+    void ColorModel::CommitUpdate()
+    {
+        if (m_update_depth_ <= 0)
+            return;
+
+        if (--m_update_depth_ > 0 || !m_pending_fields_)
+            return;
+
+        const Fields fields = m_pending_fields_;
+        m_pending_fields_ = Fields();
+        ++m_notification_count_;
+        emit sig_changed(fields);
+    }
+
+    quint64 ColorModel::NotificationCount() const
+    {
+        return m_notification_count_;
+    }
+
+    void ColorModel::markChanged(Fields fields)
+    {
+        m_pending_fields_ |= fields;
+
+        // 不在事务中时立即提交
+        if (m_update_depth_ == 0) {
+            BeginUpdate();
+            CommitUpdate();
+        }
+    }
+}
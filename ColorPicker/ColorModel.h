@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QObject>
+#include <QColor>
+
+namespace Custom_Control
+{
+    // 颜色选择器的HSVA状态，各子控件观察同一个模型
+    // BeginUpdate/CommitUpdate之间的修改合并为一次sig_changed
+    class ColorModel : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        enum Field
+        {
+            Hue = 0x1,
+            SaturationValue = 0x2,
+            Alpha = 0x4,
+            AllFields = Hue | SaturationValue | Alpha
+        };
+        Q_DECLARE_FLAGS(Fields, Field)
+
+        explicit ColorModel(QObject *parent = nullptr);
+        ~ColorModel() override;
+
+        void SetHue(int hue);
+        void SetSaturationValue(int saturation, int value);
+        void SetAlpha(int alpha);
+        void SetColor(const QColor &color);
+
+        int Hue() const;
+        int Saturation() const;
+        int Value() const;
+        int Alpha() const;
+        QColor Color() const;
+
+        // 可嵌套，最外层提交时才发出通知
+        void BeginUpdate();
+        void CommitUpdate();
+
+        // 已发出的sig_changed次数
+        quint64 NotificationCount() const;
+
+    signals:
+        void sig_changed(Custom_Control::ColorModel::Fields fields);
+
+    private:
+        void markChanged(Fields fields);
+
+    private:
+        int m_hue_ = 0;
+        int m_saturation_ = 255;
+        int m_value_ = 255;
+        int m_alpha_ = 255;
+
+        int m_update_depth_ = 0;
+        Fields m_pending_fields_;
+        quint64 m_notification_count_ = 0;
+    };
+
+    Q_DECLARE_OPERATORS_FOR_FLAGS(ColorModel::Fields)
+}
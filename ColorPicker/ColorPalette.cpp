@@ -1,331 +1,1420 @@
 #include "ColorPalette.h"
 #include <QPushButton>
 #include <QPainter>
+#include <QStyle>
 #include <QPaintEvent>
+#include <QMouseEvent>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWindow>
 #include <QRegularExpression>
+#include <QCache>
+#include <QHash>
+#include <QPointer>
+#include <QtMath>
+#include <functional>
+#include <cmath>
+#include <vector>
 #include "HDBasePushButton.h"
+#include "ColorPlane.h"
+#include "ColorSpace.h"
+#include "ColorParser.h"
+#include "RecentColorStore.h"
+#include "NamedColorIndex.h"
 
 namespace Custom_Control
 {
+    // ColorWheel按设备像素预先计算的极坐标表，尺寸相同的实例共享
+    struct WheelTable
+    {
+        int side;
+        int ring_width;
+        // 每个像素相对圆心的色相(0~359)，y轴向上
+        std::vector<quint16> hue;
+        // 按覆盖率抗锯齿后的色相环，预乘alpha
+        QImage ring;
+    };
+
+    namespace
+    {
+        // SV平面光栅缓存上限（KB），所有ColorSVCanvas实例共享，按最近使用淘汰
+        const int kSVPlaneCacheCost = 16 * 1024;
+        // 工作台中显示的最近使用颜色个数
+        const int kRecentSwatchCount = 12;
+
+        QCache<quint64, QImage> &svPlaneCache()
+        {
+            static QCache<quint64, QImage> cache(kSVPlaneCacheCost);
+            return cache;
+        }
+
+        // OkLch平面x方向的色度上限，略大于sRGB色域内的最大色度
+        const float kOkLchMaxChroma = 0.32f;
+        // 低于该色度时色相没有意义，保留当前色相
+        const float kAchromaticChroma = 0.002f;
+
+        ColorTriple toOkLch(const QColor &color)
+        {
+            const QRgb rgb = color.rgb();
+            ColorTriple lch;
+            ConvertFromRgb(&rgb, ColorSpaceId::OkLch, &lch, 1);
+            return lch;
+        }
+
+        quint64 svPlaneKey(ColorPlaneMode mode, int hue, const QSize &size, qreal dpr)
+        {
+            return (quint64(mode == ColorPlaneMode::OkLch) << 63)
+                | (quint64(hue) << 48)
+                | (quint64(size.width() & 0xFFFF) << 32)
+                | (quint64(size.height() & 0xFFFF) << 16)
+                | quint64(qRound(dpr * 100) & 0xFFFF);
+        }
+
+        QImage renderSVPlane(ColorPlaneMode mode, int hue, const QSize &size, qreal dpr)
+        {
+            // 逐像素转换到RGB，像素颜色与拾取结果一致
+            QImage image(size * dpr, QImage::Format_ARGB32_Premultiplied);
+            image.setDevicePixelRatio(dpr);
+            if (mode == ColorPlaneMode::OkLch)
+                FillOkLchPlane(image, hue, kOkLchMaxChroma);
+            else
+                FillSVPlane(image, hue);
+
+            return image;
+        }
+
+        // 从共享缓存取平面光栅，未命中时渲染后放入
+        QImage cachedPlane(ColorPlaneMode mode, int hue, const QSize &size, qreal dpr)
+        {
+            const quint64 key = svPlaneKey(mode, hue, size, dpr);
+
+            QCache<quint64, QImage> &cache = svPlaneCache();
+            if (const QImage *cached = cache.object(key))
+                return *cached;
+
+            const QImage image = renderSVPlane(mode, hue, size, dpr);
+            cache.insert(key, new QImage(image), qMax(1, int(image.sizeInBytes() / 1024)));
+            return image;
+        }
+
+        std::shared_ptr<const WheelTable> buildWheelTable(int side, int ring_width)
+        {
+            std::shared_ptr<WheelTable> table = std::make_shared<WheelTable>();
+            table->side = side;
+            table->ring_width = ring_width;
+            table->hue.resize(size_t(side) * side);
+            table->ring = QImage(side, side, QImage::Format_ARGB32_Premultiplied);
+
+            QRgb hue_colors[360];
+            for (int hue = 0; hue < 360; ++hue)
+                hue_colors[hue] = QColor::fromHsv(hue, 255, 255).rgb();
+
+            // 只在建表时逐像素求角度与半径
+            const float center = side * 0.5f;
+            const float outer = center;
+            const float inner = outer - ring_width;
+            const float degrees_per_radian = 57.29577951308232f;
+            for (int y = 0; y < side; ++y) {
+                QRgb *line = reinterpret_cast<QRgb *>(table->ring.scanLine(y));
+                quint16 *hues = table->hue.data() + size_t(y) * side;
+                const float fy = center - (y + 0.5f);
+                for (int x = 0; x < side; ++x) {
+                    const float fx = x + 0.5f - center;
+                    float angle = std::atan2(fy, fx) * degrees_per_radian;
+                    if (angle < 0)
+                        angle += 360.0f;
+                    const int hue = int(angle + 0.5f) % 360;
+                    hues[x] = quint16(hue);
+
+                    const float radius = std::sqrt(fx * fx + fy * fy);
+                    const float coverage = qBound(0.0f, outer - radius + 0.5f, 1.0f) * qBound(0.0f, radius - inner + 0.5f, 1.0f);
+                    const int alpha = int(coverage * 255 + 0.5f);
+                    line[x] = alpha ? qPremultiply(qRgba(qRed(hue_colors[hue]), qGreen(hue_colors[hue]), qBlue(hue_colors[hue]), alpha)) : 0;
+                }
+            }
+
+            return table;
+        }
+
+        // 同尺寸的表只建一次，最后一个使用者释放后随之释放
+        std::shared_ptr<const WheelTable> wheelTable(int side, int ring_width)
+        {
+            static QHash<quint64, std::weak_ptr<const WheelTable>> tables;
+
+            const quint64 key = (quint64(side) << 32) | quint64(ring_width);
+            std::shared_ptr<const WheelTable> table = tables.value(key).lock();
+            if (table)
+                return table;
+
+            for (auto it = tables.begin(); it != tables.end();) {
+                if (it->expired())
+                    it = tables.erase(it);
+                else
+                    ++it;
+            }
+
+            table = buildWheelTable(side, ring_width);
+            tables.insert(key, table);
+            return table;
+        }
+
+        // 进程内共享的2×2棋盘格贴图，作为画刷纹理平铺
+        // 贴图按设备像素生成，不同DPR各占一项，避免在高分屏上被放大而模糊
+        QBrush checkerBrush(int cell_size, qreal dpr)
+        {
+            static QHash<quint64, QBrush> brushes;
+
+            const quint64 key = (quint64(cell_size) << 32) | quint64(qRound(dpr * 100));
+            auto it = brushes.find(key);
+            if (it == brushes.end()) {
+                const int device_cell = qMax(1, qRound(cell_size * dpr));
+                QImage tile(device_cell * 2, device_cell * 2, QImage::Format_RGB32);
+                tile.fill(Qt::white);
+
+                QPainter painter(&tile);
+                painter.fillRect(0, 0, device_cell, device_cell, Qt::darkGray);
+                painter.fillRect(device_cell, device_cell, device_cell, device_cell, Qt::darkGray);
+                painter.end();
+
+                tile.setDevicePixelRatio(dpr);
+                it = brushes.insert(key, QBrush(tile));
+            }
+
+            return *it;
+        }
+
+        // 顶层窗口换到另一块屏幕后调用fn，此时DPR可能已变化
+        // 窗口句柄在首次显示时才创建，须在showEvent中调用；重复调用替换旧连接
+        void watchScreen(QWidget *widget, QMetaObject::Connection &connection, const std::function<void()> &fn)
+        {
+            QObject::disconnect(connection);
+
+            QWindow *window = widget->window()->windowHandle();
+            if (window)
+                connection = QObject::connect(window, &QWindow::screenChanged, widget, [fn](QScreen *) { fn(); });
+        }
+
+        // 所有ColorPalette共享一个ColorWorkbench，首次打开时才创建
+        // 弹出框为Qt::Popup，同一时刻只会有一个处于打开状态，单实例即可
+        // 打开时挂到当前调色板所在的窗口下，随该窗口销毁，下次打开再重建
+        QPointer<ColorWorkbench> &workbenchInstance()
+        {
+            static QPointer<ColorWorkbench> workbench;
+            return workbench;
+        }
+
+        void deleteSharedWorkbench()
+        {
+            delete workbenchInstance().data();
+        }
+
+        ColorWorkbench *sharedWorkbench()
+        {
+            QPointer<ColorWorkbench> &workbench = workbenchInstance();
+            if (!workbench) {
+                workbench = new ColorWorkbench();
+                // 尚未挂到任何窗口时由应用退出前删除
+                QObject::connect(qApp, &QCoreApplication::aboutToQuit, workbench.data(), &deleteSharedWorkbench);
+            }
+            return workbench;
+        }
+
+        QPointer<ColorPalette> &popupOwner()
+        {
+            static QPointer<ColorPalette> owner;
+            return owner;
+        }
+
+        QPoint mousePos(const QMouseEvent *ev)
+        {
+#if QT_VERSION < QT_VERSION_CHECK(6,0,0)
+            return ev->pos();
+#else
+            return ev->position().toPoint();
+#endif
+        }
+    }
+
+    GradientSlider::GradientSlider(QWidget *parent)
+        : QAbstractSlider(parent)
+        , m_groove_height_(12)
+        , m_handle_width_(6)
+        , m_checker_size_(6)
+    {
+        setOrientation(Qt::Horizontal);
+        setFocusPolicy(Qt::StrongFocus);
+        setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    }
+
+    GradientSlider::~GradientSlider()
+    {
+
+    }
+
+    void GradientSlider::SetStops(const QGradientStops &stops)
+    {
+        if (m_stops_ == stops)
+            return;
+
+        m_stops_ = stops;
+        invalidateGroove();
+    }
+
+    QGradientStops GradientSlider::Stops() const
+    {
+        return m_stops_;
+    }
+
+    void GradientSlider::SetCheckerboard(bool enable)
+    {
+        if (m_checkerboard_ == enable)
+            return;
+
+        m_checkerboard_ = enable;
+        invalidateGroove();
+    }
+
+    bool GradientSlider::Checkerboard() const
+    {
+        return m_checkerboard_;
+    }
+
+    void GradientSlider::SetGrooveHeight(int height)
+    {
+        if (height <= 0 || m_groove_height_ == height)
+            return;
+
+        m_groove_height_ = height;
+        updateGeometry();
+        invalidateGroove();
+    }
+
+    int GradientSlider::GrooveHeight() const
+    {
+        return m_groove_height_;
+    }
+
+    QSize GradientSlider::sizeHint() const
+    {
+        return QSize(100, m_groove_height_ + 4);
+    }
+
+    void GradientSlider::paintEvent(QPaintEvent *)
+    {
+        QPainter painter(this);
+
+        const QRect groove = grooveRect();
+        if (m_groove_cache_.isNull()
+            || !qFuzzyCompare(m_groove_cache_.devicePixelRatio(), devicePixelRatioF())) {
+            rebuildGroove();
+        }
+        painter.drawPixmap(groove.topLeft(), m_groove_cache_);
+
+        // 手柄样式与原QSS一致：白底、灰色1px边框、2px圆角
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(QColor(Qt::gray));
+        painter.setBrush(Qt::white);
+        painter.drawRoundedRect(QRectF(handleRect()).adjusted(0.5, 0.5, -0.5, -0.5), 2, 2);
+    }
+
+    void GradientSlider::resizeEvent(QResizeEvent *ev)
+    {
+        QAbstractSlider::resizeEvent(ev);
+        invalidateGroove();
+    }
+
+    void GradientSlider::showEvent(QShowEvent *ev)
+    {
+        QAbstractSlider::showEvent(ev);
+        watchScreen(this, m_screen_connection_, [this] {
+            invalidateGroove();
+            });
+    }
+
+    void GradientSlider::mousePressEvent(QMouseEvent *ev)
+    {
+        if (ev->button() != Qt::LeftButton) {
+            QAbstractSlider::mousePressEvent(ev);
+            return;
+        }
+
+        setSliderDown(true);
+        setSliderPosition(valueFromX(mousePos(ev).x()));
+        ev->accept();
+    }
+
+    void GradientSlider::mouseMoveEvent(QMouseEvent *ev)
+    {
+        if (!isSliderDown()) {
+            QAbstractSlider::mouseMoveEvent(ev);
+            return;
+        }
+
+        setSliderPosition(valueFromX(mousePos(ev).x()));
+        ev->accept();
+    }
+
+    void GradientSlider::mouseReleaseEvent(QMouseEvent *ev)
+    {
+        if (!isSliderDown() || ev->button() != Qt::LeftButton) {
+            QAbstractSlider::mouseReleaseEvent(ev);
+            return;
+        }
+
+        setSliderPosition(valueFromX(mousePos(ev).x()));
+        setSliderDown(false);
+        ev->accept();
+    }
+
+    QRect GradientSlider::grooveRect() const
+    {
+        return QRect(0, (height() - m_groove_height_) / 2, width(), m_groove_height_);
+    }
+
+    QRect GradientSlider::handleRect() const
+    {
+        const QRect groove = grooveRect();
+        const int pos = QStyle::sliderPositionFromValue(minimum(), maximum(), sliderPosition(),
+            groove.width() - m_handle_width_, invertedAppearance());
+
+        return QRect(groove.left() + pos, groove.top() - 2, m_handle_width_, groove.height() + 4);
+    }
+
+    int GradientSlider::valueFromX(int x) const
+    {
+        const QRect groove = grooveRect();
+        return QStyle::sliderValueFromPosition(minimum(), maximum(), x - groove.left() - m_handle_width_ / 2,
+            groove.width() - m_handle_width_, invertedAppearance());
+    }
+
+    void GradientSlider::invalidateGroove()
+    {
+        m_groove_cache_ = QPixmap();
+        update();
+    }
+
+    void GradientSlider::rebuildGroove()
+    {
+        const QRect rect(QPoint(0, 0), grooveRect().size());
+        const qreal dpr = devicePixelRatioF();
+
+        m_groove_cache_ = QPixmap(rect.size() * dpr);
+        m_groove_cache_.setDevicePixelRatio(dpr);
+        m_groove_cache_.fill(Qt::transparent);
+
+        QPainter painter(&m_groove_cache_);
+        if (m_checkerboard_)
+            painter.fillRect(rect, checkerBrush(m_checker_size_, dpr));
+
+        QLinearGradient gradient(rect.topLeft(), rect.topRight());
+        gradient.setStops(m_stops_);
+        painter.fillRect(rect, gradient);
+    }
 
     ColorHueBar::ColorHueBar(QWidget *parent)
+        : GradientSlider(parent)
+    {
+        updateStops();
+
+        setMaximum(359);
+        setInvertedAppearance(true);
+        setFixedHeight(16);
+
+        SetValue(maximum());
+        connect(this, &QAbstractSlider::valueChanged, this, [this] {
+            if (m_mode_ == ColorPlaneMode::Hsv) {
+                if (m_model_ && !m_syncing_)
+                    m_model_->SetHue(Value());
+
+                emit sig_valueChanged(Value());
+                return;
+            }
+
+            // 色相经画布写入模型，期间忽略模型回传，避免由颜色反推的色相取整后拉动滑块
+            if (m_syncing_)
+                return;
+
+            m_syncing_ = true;
+            emit sig_valueChanged(Value());
+            m_syncing_ = false;
+            });
+    }
+
+    ColorHueBar::~ColorHueBar()
+    {
+
+    }
+
+    void ColorHueBar::SetValue(int val)
+    {
+        setValue(val);
+    }
+
+    int ColorHueBar::Value() const
+    {
+        return value();
+    }
+
+    void ColorHueBar::SetModel(ColorModel *model)
+    {
+        if (m_model_ == model)
+            return;
+
+        if (m_model_)
+            disconnect(m_model_, nullptr, this, nullptr);
+
+        m_model_ = model;
+        if (m_model_) {
+            connect(m_model_, &ColorModel::sig_changed, this, &ColorHueBar::slot_modelChanged);
+            slot_modelChanged(ColorModel::AllFields);
+        }
+    }
+
+    void ColorHueBar::SetPlaneMode(ColorPlaneMode mode)
+    {
+        if (m_mode_ == mode)
+            return;
+
+        m_mode_ = mode;
+        updateStops();
+        if (m_model_)
+            slot_modelChanged(ColorModel::AllFields);
+    }
+
+    ColorPlaneMode ColorHueBar::PlaneMode() const
+    {
+        return m_mode_;
+    }
+
+    void ColorHueBar::slot_modelChanged(ColorModel::Fields fields)
+    {
+        if (m_syncing_)
+            return;
+
+        if (m_mode_ == ColorPlaneMode::Hsv) {
+            if (!(fields & ColorModel::Hue))
+                return;
+
+            m_syncing_ = true;
+            SetValue(m_model_->Hue());
+            m_syncing_ = false;
+            return;
+        }
+
+        if (!(fields & (ColorModel::Hue | ColorModel::SaturationValue)))
+            return;
+
+        const ColorTriple lch = toOkLch(m_model_->Color());
+        if (lch.c1 < kAchromaticChroma)
+            return;
+
+        m_syncing_ = true;
+        SetValue(qRound(lch.c2) % 360);
+        m_syncing_ = false;
+    }
+
+    void ColorHueBar::updateStops()
+    {
+        // 色相从左(359)到右(0)递减
+        QGradientStops stops;
+        if (m_mode_ == ColorPlaneMode::OkLch) {
+            // 固定亮度与色度，色相条上各处的明暗一致
+            const int kStopCount = 13;
+            for (int i = kStopCount - 1; i >= 0; --i) {
+                const float hue = 359.0f * i / (kStopCount - 1);
+                stops.append(QGradientStop(1 - qreal(i) / (kStopCount - 1), QColor(OkLchToRgbInGamut(0.75f, 0.12f, hue))));
+            }
+        }
+        else {
+            const qreal positions[] = { 0, 0.17, 0.33, 0.5, 0.67, 0.83, 1 };
+            const int hues[] = { 0, 59, 119, 179, 239, 299, 359 };
+            for (int i = 6; i >= 0; --i)
+                stops.append(QGradientStop(1 - positions[i], QColor::fromHsv(hues[i], 255, 255)));
+        }
+        SetStops(stops);
+    }
+
+    ColorSVCanvas::ColorSVCanvas(QWidget *parent)
         : QWidget(parent)
+        , m_margin_(5)
+        , m_radius_(m_margin_ - 1)
+        , m_saturation_max_(255)
+        , m_value_max_(255)
+        , m_hue_(0)
+        , m_pos_(QPoint(-1, -1))
+    {
+        m_frame_timer_ = new QTimer(this);
+        m_frame_timer_->setSingleShot(true);
+        m_frame_timer_->setTimerType(Qt::PreciseTimer);
+        connect(m_frame_timer_, &QTimer::timeout, this, [this] {
+            flushCursorPos(false);
+            });
+
+        installEventFilter(this);
+    }
+
+    ColorSVCanvas::~ColorSVCanvas()
+    {
+        removeEventFilter(this);
+    }
+
+    bool ColorSVCanvas::SetHue(int hue)
+    {
+        if (hue < 0 || hue > 359)
+            return false;
+
+        m_hue_ = hue;
+
+        update();
+        publishColor();
+
+        return true;
+    }
+
+    bool ColorSVCanvas::SetSaturationValue(int saturation, int value)
+    {
+        return SetSaturationValue(QPoint(saturation, value));
+    }
+
+    bool ColorSVCanvas::SetSaturationValue(QPoint saturationValue)
+    {
+        if (!QRect(0, 0, 256, 256).contains(saturationValue))
+            return false;
+
+        setCursorPos(posFromValue(saturationValue));
+        publishColor();
+
+        return true;
+    }
+
+    QColor ColorSVCanvas::Color()
+    {
+        const QPoint tmpVal = valueFromPos(m_pos_);
+        QColor tmpColor;
+        if (m_mode_ == ColorPlaneMode::OkLch)
+            tmpColor = QColor(OkLchToRgbInGamut(tmpVal.y() / 255.0f, tmpVal.x() / 255.0f * kOkLchMaxChroma, float(m_hue_)));
+        else
+            tmpColor.setHsv(m_hue_, tmpVal.x(), tmpVal.y());
+        return tmpColor;
+    }
+
+    QRect ColorSVCanvas::AvailabilityRect() const
+    {
+        const QRect tmpRect(m_margin_, m_margin_, width() - m_margin_ * 2, height() - m_margin_ * 2);
+        return tmpRect;
+    }
+
+    int ColorSVCanvas::Margin() const
+    {
+        return m_margin_;
+    }
+
+    qint64 ColorSVCanvas::LastPaintPixels() const
+    {
+        return m_last_paint_pixels_;
+    }
+
+    void ColorSVCanvas::SetModel(ColorModel *model)
+    {
+        if (m_model_ == model)
+            return;
+
+        if (m_model_)
+            disconnect(m_model_, nullptr, this, nullptr);
+
+        m_model_ = model;
+        if (m_model_) {
+            connect(m_model_, &ColorModel::sig_changed, this, &ColorSVCanvas::slot_modelChanged);
+            slot_modelChanged(ColorModel::AllFields);
+        }
+    }
+
+    void ColorSVCanvas::SetPlaneMode(ColorPlaneMode mode)
+    {
+        if (m_mode_ == mode)
+            return;
+
+        m_mode_ = mode;
+        if (m_model_)
+            syncFromModel(ColorModel::AllFields);
+        update();
+    }
+
+    ColorPlaneMode ColorSVCanvas::PlaneMode() const
+    {
+        return m_mode_;
+    }
+
+    void ColorSVCanvas::slot_modelChanged(ColorModel::Fields fields)
+    {
+        // 自身写入模型引起的通知不再回写，避免圆环因取整抖动
+        if (m_syncing_)
+            return;
+
+        syncFromModel(fields);
+    }
+
+    void ColorSVCanvas::syncFromModel(ColorModel::Fields fields)
+    {
+        if (m_mode_ == ColorPlaneMode::Hsv) {
+            if (fields & ColorModel::Hue) {
+                m_hue_ = m_model_->Hue();
+                update();
+            }
+
+            if ((fields & ColorModel::SaturationValue) && !AvailabilityRect().isEmpty()) {
+                QPoint value(m_model_->Saturation(), m_model_->Value());
+                setCursorPos(posFromValue(value));
+            }
+            return;
+        }
+
+        if (!(fields & (ColorModel::Hue | ColorModel::SaturationValue)))
+            return;
+
+        const ColorTriple lch = toOkLch(m_model_->Color());
+        if (lch.c1 >= kAchromaticChroma) {
+            const int hue = qRound(lch.c2) % 360;
+            if (hue != m_hue_) {
+                m_hue_ = hue;
+                update();
+            }
+        }
+
+        if (!AvailabilityRect().isEmpty()) {
+            QPoint value(qBound(0, qRound(lch.c1 / kOkLchMaxChroma * 255), 255), qBound(0, qRound(lch.c0 * 255), 255));
+            setCursorPos(posFromValue(value));
+        }
+    }
+
+    void ColorSVCanvas::paintEvent(QPaintEvent *ev)
+    {
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+
+        const QRect rect = AvailabilityRect();
+        const QImage plane = planeImage();
+        const qreal dpr = plane.devicePixelRatio();
+
+        // 只回填脏区域下方的平面像素
+        qint64 pixels = 0;
+        for (const QRect &dirty : ev->region()) {
+            const QRect target = dirty & rect;
+            if (target.isEmpty())
+                continue;
+
+            const QRectF source(QPointF(target.topLeft() - rect.topLeft()) * dpr, QSizeF(target.size()) * dpr);
+            painter.drawImage(QRectF(target), plane, source);
+            pixels += qint64(target.width()) * target.height();
+        }
+        m_last_paint_pixels_ = qRound64(pixels * dpr * dpr);
+
+        painter.setPen(QColor(Qt::darkGray));
+        painter.drawEllipse(m_pos_, m_radius_, m_radius_);
+    }
+
+    void ColorSVCanvas::showEvent(QShowEvent *ev)
+    {
+        QWidget::showEvent(ev);
+        watchScreen(this, m_screen_connection_, [this] {
+            m_plane_ = QImage();
+            update();
+            });
+    }
+
+    void ColorSVCanvas::resizeEvent(QResizeEvent *)
+    {
+        if (m_model_ && m_mode_ == ColorPlaneMode::OkLch) {
+            syncFromModel(ColorModel::AllFields);
+        }
+        else if (m_model_) {
+            QPoint value(m_model_->Saturation(), m_model_->Value());
+            m_pos_ = posFromValue(value);
+        }
+        else if (m_pos_ == QPoint(-1, -1)) {
+            SetSaturationValue(255, 255);
+        }
+    }
+
+    bool ColorSVCanvas::eventFilter(QObject *obj, QEvent *ev)
+    {
+        if (obj == this) {
+            switch (ev->type()) {
+            case QEvent::MouseButtonPress:
+            case QEvent::MouseButtonDblClick: {
+                const QPoint pos = mousePos(static_cast<QMouseEvent *>(ev));
+                if (!AvailabilityRect().contains(pos))
+                    break;
+
+                m_dragging_ = true;
+                m_has_pending_pos_ = false;
+                m_frame_timer_->stop();
+
+                setCursorPos(pos);
+                m_frame_clock_.start();
+                publishColor();
+
+                if (ev->type() == QEvent::MouseButtonDblClick)
+                    emit sig_doubleClick();
+
+                return true;
+            }
+            case QEvent::MouseMove:
+                if (!m_dragging_)
+                    break;
+
+                queueCursorPos(clampToRect(mousePos(static_cast<QMouseEvent *>(ev))));
+                return true;
+            case QEvent::MouseButtonRelease: {
+                const QPoint pos = mousePos(static_cast<QMouseEvent *>(ev));
+                if (!m_dragging_ && !AvailabilityRect().contains(pos))
+                    break;
+
+                // 松开时无论位置是否变化都发出最终颜色
+                m_dragging_ = false;
+                m_frame_timer_->stop();
+                m_pending_pos_ = clampToRect(pos);
+                m_has_pending_pos_ = true;
+                flushCursorPos(true);
+
+                return true;
+            }
+            default:
+                break;
+            }
+        }
+        return QWidget::eventFilter(obj, ev);
+    }
+
+    QPoint ColorSVCanvas::clampToRect(const QPoint &pos) const
+    {
+        const QRect rect = AvailabilityRect();
+        return QPoint(qBound(rect.left(), pos.x(), rect.right()), qBound(rect.top(), pos.y(), rect.bottom()));
+    }
+
+    int ColorSVCanvas::frameInterval() const
+    {
+        const QWindow *window = this->window()->windowHandle();
+        const QScreen *screen = window ? window->screen() : QGuiApplication::primaryScreen();
+        const qreal refresh_rate = screen ? screen->refreshRate() : 60.0;
+
+        return qMax(1, qRound(1000.0 / (refresh_rate > 0 ? refresh_rate : 60.0)));
+    }
+
+    QRect ColorSVCanvas::ringRect(const QPoint &pos) const
+    {
+        // 半径外留出画笔宽度与抗锯齿的余量
+        const int extent = m_radius_ + 2;
+        return QRect(pos.x() - extent, pos.y() - extent, extent * 2 + 1, extent * 2 + 1);
+    }
+
+    void ColorSVCanvas::setCursorPos(const QPoint &pos)
+    {
+        // 只有圆环移动时仅重绘新旧圆环所覆盖的区域
+        QRegion dirty(ringRect(m_pos_));
+        dirty += ringRect(pos);
+
+        m_pos_ = pos;
+        update(dirty);
+    }
+
+    void ColorSVCanvas::queueCursorPos(const QPoint &pos)
+    {
+        m_pending_pos_ = pos;
+        m_has_pending_pos_ = true;
+
+        if (m_frame_timer_->isActive())
+            return;
+
+        // 距上次刷新已满一帧则立即刷新，否则等到下一帧
+        const int interval = frameInterval();
+        const qint64 elapsed = m_frame_clock_.isValid() ? m_frame_clock_.elapsed() : interval;
+        if (elapsed >= interval)
+            flushCursorPos(false);
+        else
+            m_frame_timer_->start(int(interval - elapsed));
+    }
+
+    void ColorSVCanvas::flushCursorPos(bool is_final)
+    {
+        if (!m_has_pending_pos_)
+            return;
+
+        m_has_pending_pos_ = false;
+        m_frame_clock_.start();
+
+        const bool moved = m_pending_pos_ != m_pos_;
+        if (moved)
+            setCursorPos(m_pending_pos_);
+
+        if (moved || is_final)
+            publishColor();
+    }
+
+    void ColorSVCanvas::publishColor()
+    {
+        if (m_model_ && m_mode_ == ColorPlaneMode::OkLch) {
+            QColor color = Color();
+            color.setAlpha(m_model_->Alpha());
+            m_syncing_ = true;
+            m_model_->SetColor(color);
+            m_syncing_ = false;
+        }
+        else if (m_model_) {
+            m_syncing_ = true;
+            m_model_->BeginUpdate();
+            m_model_->SetHue(m_hue_);
+            const QPoint value = valueFromPos(m_pos_);
+            m_model_->SetSaturationValue(value.x(), value.y());
+            m_model_->CommitUpdate();
+            m_syncing_ = false;
+        }
+
+        emit sig_colorChanged(Color());
+    }
+
+    QImage ColorSVCanvas::planeImage() const
+    {
+        const QSize size = AvailabilityRect().size();
+        if (size.isEmpty())
+            return QImage();
+
+        // 上次使用的平面保存在控件内，拖动圆环时的重绘不必查共享缓存
+        const qreal dpr = devicePixelRatioF();
+        const quint64 key = svPlaneKey(m_mode_, m_hue_, size, dpr);
+        if (!m_plane_.isNull() && m_plane_key_ == key)
+            return m_plane_;
+
+        m_plane_ = cachedPlane(m_mode_, m_hue_, size, dpr);
+        m_plane_key_ = key;
+        return m_plane_;
+    }
+
+    QPoint ColorSVCanvas::valueFromPos(QPoint &pos) const
+    {
+        const QRect tmp_rect = AvailabilityRect();
+
+        const QPoint tmp_pos = pos - tmp_rect.topLeft();
+        const int saturation = tmp_pos.x() * m_saturation_max_ / tmp_rect.width();
+        const int value = qAbs(tmp_pos.y() * m_value_max_ / tmp_rect.height() - m_value_max_);
+
+        return QPoint(saturation, value);
+    }
+
+    QPoint ColorSVCanvas::posFromValue(QPoint &val) const
+    {
+        const QRect tmp_rect = AvailabilityRect();
+
+        const int tmp_x = val.x() * tmp_rect.width() / m_saturation_max_;
+        const int tmp_y = qAbs(val.y() - m_value_max_) * tmp_rect.height() / m_value_max_;
+
+        return QPoint(tmp_x, tmp_y) + tmp_rect.topLeft();
+    }
+
+    ColorWheel::ColorWheel(QWidget *parent)
+        : QWidget(parent)
+        , m_margin_(2)
+        , m_ring_width_(14)
+        , m_radius_(4)
+    {
+
+    }
+
+    ColorWheel::~ColorWheel()
+    {
+
+    }
+
+    bool ColorWheel::SetHue(int hue)
+    {
+        if (hue < 0 || hue > 359)
+            return false;
+
+        if (m_hue_ != hue) {
+            m_hue_ = hue;
+            update();
+        }
+        publishColor();
+
+        return true;
+    }
+
+    int ColorWheel::Hue() const
+    {
+        return m_hue_;
+    }
+
+    bool ColorWheel::SetSaturationValue(int saturation, int value)
+    {
+        if (!QRect(0, 0, 256, 256).contains(saturation, value))
+            return false;
+
+        m_saturation_ = saturation;
+        m_value_ = value;
+        update();
+        publishColor();
+
+        return true;
+    }
+
+    QColor ColorWheel::Color() const
+    {
+        return QColor::fromHsv(m_hue_, m_saturation_, m_value_);
+    }
+
+    void ColorWheel::SetRingWidth(int width)
+    {
+        if (width < 1 || m_ring_width_ == width)
+            return;
+
+        m_ring_width_ = width;
+        m_table_.reset();
+        update();
+    }
+
+    int ColorWheel::RingWidth() const
+    {
+        return m_ring_width_;
+    }
+
+    void ColorWheel::SetModel(ColorModel *model)
     {
-        m_slider_ = new QSlider(this);
-        m_slider_->setMaximum(359);
-        m_slider_->setFixedHeight(16);
-        m_slider_->setStyleSheet("QSlider::groove:horizontal {height: 12px; \
-                                background-color: qlineargradient(spread:pad, x1:1, y1:0, x2:0, y2:0, \
-                                    stop:0 hsv(0,255,255), \
-                                    stop:0.17 hsv(59,255,255), \
-                                    stop:0.33 hsv(119,255,255), \
-                                    stop:0.5 hsv(179,255,255), \
-                                    stop:0.67 hsv(239,255,255), \
-                                    stop:0.83 hsv(299,255,255), \
-                                    stop:1 hsv(359,255,255));} \
-                            QSlider::handle:horizontal { \
-                                background: white; \
-                                width: 4px; \
-                                margin:-2px 0px; \
-                                border: 1px solid grey; \
-                                border-radius: 2px;} \
-                            QSlider::add-page:horizontal {background: transparent;} \
-                            QSlider::sub-page:horizontal {background: transparent;}");
-
-        m_slider_->setOrientation(Qt::Orientation::Horizontal);
-
-        SetValue(m_slider_->maximum());
-        connect(m_slider_, &QSlider::valueChanged, this, [this] {
-            emit sig_valueChanged(Value());
-            });
+        if (m_model_ == model)
+            return;
 
-        m_main_hloayout_ = new QHBoxLayout(this);
-        m_main_hloayout_->setContentsMargins(0, 0, 0, 0);
-        m_main_hloayout_->setSpacing(0);
-        m_main_hloayout_->addWidget(m_slider_);
+        if (m_model_)
+            disconnect(m_model_, nullptr, this, nullptr);
+
+        m_model_ = model;
+        if (m_model_) {
+            connect(m_model_, &ColorModel::sig_changed, this, &ColorWheel::slot_modelChanged);
+            slot_modelChanged(ColorModel::AllFields);
+        }
     }
 
-    ColorHueBar::~ColorHueBar()
+    QSize ColorWheel::sizeHint() const
     {
-        if (m_slider_) {
-            m_slider_->disconnect();
-            m_slider_->deleteLater();
-        }
+        return QSize(180, 180);
+    }
+
+    void ColorWheel::slot_modelChanged(ColorModel::Fields fields)
+    {
+        if (m_syncing_)
+            return;
+
+        if (fields & ColorModel::Hue)
+            m_hue_ = m_model_->Hue();
 
-        if (m_main_hloayout_) {
-            m_main_hloayout_->deleteLater();
+        if (fields & ColorModel::SaturationValue) {
+            m_saturation_ = m_model_->Saturation();
+            m_value_ = m_model_->Value();
         }
 
+        if (fields & (ColorModel::Hue | ColorModel::SaturationValue))
+            update();
     }
 
-    void ColorHueBar::SetValue(int val) const
+    void ColorWheel::paintEvent(QPaintEvent *)
     {
-        m_slider_->setValue(qAbs(val - m_slider_->maximum()));
+        const QRect wheel = wheelRect();
+        if (wheel.isEmpty())
+            return;
+
+        QPainter painter(this);
+        painter.drawImage(QRectF(wheel), table().ring);
+
+        const QRect plane = planeRect();
+        if (!plane.isEmpty())
+            painter.drawImage(plane, cachedPlane(ColorPlaneMode::Hsv, m_hue_, plane.size(), devicePixelRatioF()));
+
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setBrush(Qt::NoBrush);
+
+        // 色相标记跨越整个环宽
+        const qreal marker = m_ring_width_ * 0.5;
+        painter.setPen(QPen(Qt::white, 2));
+        painter.drawEllipse(hueMarkerPos(), marker - 1, marker - 1);
+
+        if (!plane.isEmpty()) {
+            painter.setPen(QColor(Qt::darkGray));
+            painter.drawEllipse(posFromValue(m_saturation_, m_value_), m_radius_, m_radius_);
+        }
     }
 
-    int ColorHueBar::Value() const
+    void ColorWheel::resizeEvent(QResizeEvent *ev)
     {
-        return qAbs(m_slider_->value() - m_slider_->maximum());
+        QWidget::resizeEvent(ev);
+        m_table_.reset();
     }
 
-    ColorSVCanvas::ColorSVCanvas(QWidget *parent)
-        : QWidget(parent)
-        , m_margin_(5)
-        , m_radius_(m_margin_ - 1)
-        , m_saturation_max_(255)
-        , m_value_max_(255)
-        , m_hue_(0)
-        , m_pos_(QPoint(-1, -1))
+    void ColorWheel::showEvent(QShowEvent *ev)
     {
-        installEventFilter(this);
+        QWidget::showEvent(ev);
+        watchScreen(this, m_screen_connection_, [this] {
+            m_table_.reset();
+            update();
+            });
     }
 
-    ColorSVCanvas::~ColorSVCanvas()
+    void ColorWheel::mousePressEvent(QMouseEvent *ev)
     {
-        removeEventFilter(this);
+        if (ev->button() != Qt::LeftButton) {
+            QWidget::mousePressEvent(ev);
+            return;
+        }
+
+        const QPoint pos = mousePos(ev);
+        if (ringContains(pos))
+            m_drag_ = DragTarget::Ring;
+        else if (planeRect().contains(pos))
+            m_drag_ = DragTarget::Plane;
+        else
+            m_drag_ = DragTarget::None;
+
+        if (m_drag_ == DragTarget::None) {
+            QWidget::mousePressEvent(ev);
+            return;
+        }
+
+        dragTo(pos);
+        ev->accept();
     }
 
-    bool ColorSVCanvas::SetHue(int hue)
+    void ColorWheel::mouseMoveEvent(QMouseEvent *ev)
     {
-        if (hue < 0 || hue > 359)
-            return false;
+        if (m_drag_ == DragTarget::None) {
+            QWidget::mouseMoveEvent(ev);
+            return;
+        }
 
-        m_hue_ = hue;
+        dragTo(mousePos(ev));
+        ev->accept();
+    }
 
-        update();
-        emit sig_colorChanged(Color());
+    void ColorWheel::mouseReleaseEvent(QMouseEvent *ev)
+    {
+        if (m_drag_ == DragTarget::None || ev->button() != Qt::LeftButton) {
+            QWidget::mouseReleaseEvent(ev);
+            return;
+        }
 
-        return true;
+        dragTo(mousePos(ev));
+        m_drag_ = DragTarget::None;
+        ev->accept();
     }
 
-    bool ColorSVCanvas::SetSaturationValue(int saturation, int value)
+    void ColorWheel::mouseDoubleClickEvent(QMouseEvent *ev)
     {
-        return SetSaturationValue(QPoint(saturation, value));
+        if (ev->button() == Qt::LeftButton && planeRect().contains(mousePos(ev))) {
+            emit sig_doubleClick();
+            ev->accept();
+            return;
+        }
+
+        QWidget::mouseDoubleClickEvent(ev);
     }
 
-    bool ColorSVCanvas::SetSaturationValue(QPoint saturationValue)
+    QRect ColorWheel::wheelRect() const
     {
-        if (!QRect(0, 0, 256, 256).contains(saturationValue))
-            return false;
+        const int side = qMax(0, qMin(width(), height()) - m_margin_ * 2);
+        return QRect((width() - side) / 2, (height() - side) / 2, side, side);
+    }
 
-        m_pos_ = posFromValue(saturationValue);
+    QRect ColorWheel::planeRect() const
+    {
+        // 内接于环内侧的正方形，与环之间留出圆环标记的余量
+        const QRect wheel = wheelRect();
+        const qreal inner = wheel.width() * 0.5 - m_ring_width_ - m_radius_;
+        const int side = inner > 0 ? int(inner * M_SQRT2) : 0;
+        return QRect(wheel.center().x() - side / 2 + 1, wheel.center().y() - side / 2 + 1, side, side);
+    }
 
-        update();
-        emit sig_colorChanged(Color());
+    const WheelTable &ColorWheel::table() const
+    {
+        const int side = qMax(1, qRound(wheelRect().width() * devicePixelRatioF()));
+        const int ring_width = qMax(1, qRound(m_ring_width_ * devicePixelRatioF()));
+        if (!m_table_ || m_table_->side != side || m_table_->ring_width != ring_width)
+            m_table_ = wheelTable(side, ring_width);
 
-        return true;
+        return *m_table_;
     }
 
-    QColor ColorSVCanvas::Color()
+    bool ColorWheel::ringContains(const QPoint &pos) const
     {
-        const QPoint tmpVal = valueFromPos(m_pos_);
-        QColor tmpColor;
-        tmpColor.setHsv(m_hue_, tmpVal.x(), tmpVal.y());
-        return tmpColor;
+        // 比较距离平方，不开方
+        const QRect wheel = wheelRect();
+        const qreal dx = pos.x() - (wheel.left() + wheel.width() * 0.5);
+        const qreal dy = pos.y() - (wheel.top() + wheel.height() * 0.5);
+        const qreal outer = wheel.width() * 0.5;
+        const qreal inner = outer - m_ring_width_;
+        const qreal distance = dx * dx + dy * dy;
+
+        return distance <= outer * outer && distance >= inner * inner;
     }
 
-    QRect ColorSVCanvas::AvailabilityRect() const
+    int ColorWheel::hueAt(const QPoint &pos) const
     {
-        const QRect tmpRect(m_margin_, m_margin_, width() - m_margin_ * 2, height() - m_margin_ * 2);
-        return tmpRect;
+        const WheelTable &lut = table();
+        const QRect wheel = wheelRect();
+        const qint64 half = lut.side / 2;
+
+        // 转为相对圆心的设备像素坐标，再沿径向推到表的边缘，圆心附近也能取到足够精度的角度
+        qint64 dx = qint64(pos.x() - wheel.left()) * lut.side / qMax(1, wheel.width()) - half;
+        qint64 dy = qint64(pos.y() - wheel.top()) * lut.side / qMax(1, wheel.height()) - half;
+        const qint64 extent = qMax(qAbs(dx), qAbs(dy));
+        if (extent == 0 || half < 1)
+            return m_hue_;
+
+        dx = dx * (half - 1) / extent;
+        dy = dy * (half - 1) / extent;
+        return lut.hue[size_t((dy + half) * lut.side + dx + half)];
     }
 
-    int ColorSVCanvas::Margin() const
+    QPoint ColorWheel::valueFromPos(const QPoint &pos) const
     {
-        return m_margin_;
+        // 与FillSVPlane的像素映射一致
+        const QRect rect = planeRect();
+        const int x = qBound(0, pos.x() - rect.left(), rect.width() - 1);
+        const int y = qBound(0, pos.y() - rect.top(), rect.height() - 1);
+
+        return QPoint(x * 255 / rect.width(), 255 - y * 255 / rect.height());
     }
 
-    void ColorSVCanvas::paintEvent(QPaintEvent *)
+    QPoint ColorWheel::posFromValue(int saturation, int value) const
     {
-        QPainter painter(this);
-        painter.setRenderHint(QPainter::Antialiasing);
+        const QRect rect = planeRect();
+        return QPoint(rect.left() + saturation * rect.width() / 255, rect.top() + (255 - value) * rect.height() / 255);
+    }
 
-        const QRect rect = AvailabilityRect();
+    QPointF ColorWheel::hueMarkerPos() const
+    {
+        const QRectF wheel(wheelRect());
+        const qreal radius = wheel.width() * 0.5 - m_ring_width_ * 0.5;
+        const qreal angle = qDegreesToRadians(qreal(m_hue_));
+        return wheel.center() + QPointF(radius * std::cos(angle), -radius * std::sin(angle));
+    }
 
-        // 绘制从左到右RGB(255,255,255)到HSV(h,255,255)的渐变
-        QLinearGradient linearGradientH(rect.topLeft(), rect.topRight());
-        linearGradientH.setColorAt(0, Qt::white);
-        QColor color;
-        color.setHsv(m_hue_, m_saturation_max_, m_value_max_);
-        linearGradientH.setColorAt(1, color);
-        painter.fillRect(rect, linearGradientH);
+    void ColorWheel::dragTo(const QPoint &pos)
+    {
+        if (m_drag_ == DragTarget::Ring) {
+            const int hue = hueAt(pos);
+            if (hue == m_hue_)
+                return;
 
-        // 绘制顶部颜色值为RGBA(0,0,0,0)到最底部RGBA(0,0,0,255)的渐变
-        QLinearGradient linearGradientV(rect.topLeft(), rect.bottomLeft());
-        linearGradientV.setColorAt(0, QColor(0, 0, 0, 0));
-        linearGradientV.setColorAt(1, QColor(0, 0, 0, 255));
-        painter.fillRect(rect, linearGradientV);
+            m_hue_ = hue;
+        }
+        else if (m_drag_ == DragTarget::Plane) {
+            if (planeRect().isEmpty())
+                return;
 
-        painter.setPen(QColor(Qt::darkGray));
-        painter.drawEllipse(m_pos_, m_radius_, m_radius_);
+            const QPoint value = valueFromPos(pos);
+            if (value.x() == m_saturation_ && value.y() == m_value_)
+                return;
+
+            m_saturation_ = value.x();
+            m_value_ = value.y();
+        }
+
+        update();
+        publishColor();
     }
 
-    void ColorSVCanvas::resizeEvent(QResizeEvent *)
+    void ColorWheel::publishColor()
     {
-        if (m_pos_ == QPoint(-1, -1)) {
-            SetSaturationValue(255, 255);
+        if (m_model_) {
+            m_syncing_ = true;
+            m_model_->BeginUpdate();
+            m_model_->SetHue(m_hue_);
+            m_model_->SetSaturationValue(m_saturation_, m_value_);
+            m_model_->CommitUpdate();
+            m_syncing_ = false;
         }
+
+        emit sig_colorChanged(Color());
     }
 
-    bool ColorSVCanvas::eventFilter(QObject *obj, QEvent *ev)
+    ColorChecker::ColorChecker(QWidget *parent)
+        : QWidget(parent)
+        , m_checker_size_(6)
     {
-        if (obj == this) {
-            if (ev->type() == QEvent::MouseButtonPress || ev->type() == QEvent::MouseButtonDblClick
-                || ev->type() == QEvent::MouseButtonRelease) {
-                if (AvailabilityRect().contains(mapFromGlobal(QCursor::pos()))) {
-                    m_pos_ = mapFromGlobal(QCursor::pos());
-                    update();
-                    emit sig_colorChanged(Color());
 
-                    if (ev->type() == QEvent::MouseButtonDblClick)
-                        emit sig_doubleClick();
+    }
+
+    ColorChecker::~ColorChecker()
+    {
 
-                    return true;
-                }
-            }
-        }
-        return QWidget::eventFilter(obj, ev);
     }
 
-    QPoint ColorSVCanvas::valueFromPos(QPoint &pos) const
+    void ColorChecker::showEvent(QShowEvent *ev)
     {
-        const QRect tmp_rect = AvailabilityRect();
+        QWidget::showEvent(ev);
+        watchScreen(this, m_screen_connection_, [this] {
+            update();
+            });
+    }
 
-        const QPoint tmp_pos = pos - tmp_rect.topLeft();
-        const int saturation = tmp_pos.x() * m_saturation_max_ / tmp_rect.width();
-        const int value = qAbs(tmp_pos.y() * m_value_max_ / tmp_rect.height() - m_value_max_);
+    void ColorChecker::paintEvent(QPaintEvent *ev)
+    {
+        // 纹理与控件原点对齐，只填充暴露区域
+        QPainter painter(this);
+        painter.setBrushOrigin(0, 0);
+        painter.fillRect(ev->rect(), checkerBrush(m_checker_size_, devicePixelRatioF()));
+    }
+
+    ColorSwatch::ColorSwatch(QWidget *parent)
+        : QAbstractButton(parent)
+        , m_color_(Qt::white)
+        , m_border_color_(152, 152, 152)
+        , m_checker_size_(6)
+    {
 
-        return QPoint(saturation, value);
     }
 
-    QPoint ColorSVCanvas::posFromValue(QPoint &val) const
+    ColorSwatch::~ColorSwatch()
     {
-        const QRect tmp_rect = AvailabilityRect();
 
-        const int tmp_x = val.x() * tmp_rect.width() / m_saturation_max_;
-        const int tmp_y = qAbs(val.y() - m_value_max_) * tmp_rect.height() / m_value_max_;
+    }
 
-        return QPoint(tmp_x, tmp_y) + tmp_rect.topLeft();
+    void ColorSwatch::SetColor(const QColor &color)
+    {
+        if (m_color_ == color)
+            return;
+
+        m_color_ = color;
+        update();
     }
 
-    ColorChecker::ColorChecker(QWidget *parent)
-        : QWidget(parent)
-        , m_checker_size_(6)
+    QColor ColorSwatch::Color() const
     {
+        return m_color_;
+    }
+
+    void ColorSwatch::SetBorderColor(const QColor &color)
+    {
+        if (m_border_color_ == color)
+            return;
 
+        m_border_color_ = color;
+        update();
     }
 
-    ColorChecker::~ColorChecker()
+    QColor ColorSwatch::BorderColor() const
     {
+        return m_border_color_;
+    }
 
+    QSize ColorSwatch::sizeHint() const
+    {
+        return QSize(30, 30);
     }
 
-    void ColorChecker::paintEvent(QPaintEvent *ev)
+    void ColorSwatch::showEvent(QShowEvent *ev)
+    {
+        QAbstractButton::showEvent(ev);
+        watchScreen(this, m_screen_connection_, [this] {
+            update();
+            });
+    }
+
+    void ColorSwatch::paintEvent(QPaintEvent *)
     {
         QPainter painter(this);
-        painter.setRenderHint(QPainter::Antialiasing);
 
-        const int row_count = ev->rect().height() / m_checker_size_ + 1;
-        const int col_count = ev->rect().width() / m_checker_size_ + 1;
+        // 半透明颜色叠加在棋盘格上
+        const QRect content = rect().adjusted(1, 1, -1, -1);
+        if (m_color_.alpha() < 255) {
+            painter.setBrushOrigin(content.topLeft());
+            painter.fillRect(content, checkerBrush(m_checker_size_, devicePixelRatioF()));
+        }
+        painter.fillRect(content, m_color_);
 
-        for (int i = 0; i < row_count; i++) {
-            for (int j = 0; j < col_count; j++) {
-                QRect checker_rect(m_checker_size_ * j, m_checker_size_ * i, m_checker_size_, m_checker_size_);
+        painter.setPen(m_border_color_);
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(rect().adjusted(0, 0, -1, -1));
 
-                QColor checker_color;
-                if (((j + i % 2) % 2) == 0) {
-                    checker_color = Qt::darkGray;
-                }
-                else {
-                    checker_color = Qt::white;
-                }
-                painter.fillRect(checker_rect, checker_color);
-            }
+        if (!text().isEmpty()) {
+            painter.setPen(palette().color(QPalette::ButtonText));
+            painter.drawText(content, Qt::AlignCenter, text());
         }
     }
 
     ColorAlphaBar::ColorAlphaBar(QWidget *parent)
-        : QWidget(parent)
-        , m_groove_height_(12)
+        : GradientSlider(parent)
     {
-        m_checker_ = new ColorChecker(this);
-
-        m_slider_ = new QSlider(Qt::Horizontal, this);
-        m_slider_->setMaximum(255);
-        m_slider_->setValue(m_slider_->maximum());
-        m_slider_->setFixedHeight(16);
+        SetCheckerboard(true);
+        setMaximum(255);
+        setValue(maximum());
+        setFixedHeight(16);
         SetColor(Qt::red);
 
-        connect(m_slider_, &QSlider::valueChanged, this, [this] {
+        connect(this, &QAbstractSlider::valueChanged, this, [this] {
+            if (m_model_ && !m_syncing_)
+                m_model_->SetAlpha(value());
+
             emit sig_colorChanged(Color());
             });
-
-        m_v_box_layout_ = new (std::nothrow)QVBoxLayout(this);
-        m_v_box_layout_->setContentsMargins(0, 0, 0, 0 );
-        m_v_box_layout_->setSpacing(0);
-        m_v_box_layout_->addWidget(m_slider_);
     }
 
     ColorAlphaBar::~ColorAlphaBar()
     {
-        if (m_checker_) {
-            m_checker_->deleteLater();
-        }
-
-        if (m_slider_) {
-            m_slider_->disconnect();
-            m_slider_->deleteLater();
-        }
-
-        if (m_v_box_layout_) {
-            m_v_box_layout_->deleteLater();
-        }
 
     }
 
     void ColorAlphaBar::SetColor(QColor ori_color)
     {
-        m_color_ = ori_color;
-        m_color_.setAlpha(255);
-
-        QColor tmp_color(ori_color);
-        tmp_color.setAlpha(0);
-
-        m_slider_->setStyleSheet(QString("QSlider::groove:horizontal { \
-                                        height: %3px; \
-                                        background-color: qlineargradient(spread:pad, x1:0, y1:0, x2:1, y2:0, \
-                                        stop:0 %1, \
-                                        stop:1 %2);} \
-                                    QSlider::handle:horizontal { \
-                                        background: white; \
-                                        width: 4px; \
-                                        margin: -2px 0; \
-                                        border: 1px solid grey; \
-                                        border-radius: 2px;} \
-                                    QSlider::add-page:horizontal {background: transparent;} \
-                                    QSlider::sub-page:horizontal {background: transparent;}")
-            .arg(tmp_color.name(QColor::HexArgb))
-            .arg(m_color_.name())
-            .arg(m_groove_height_));
-
+        applyColor(ori_color);
         emit sig_colorChanged(Color());
     }
 
     QColor ColorAlphaBar::Color() const
     {
         QColor tmpColor(m_color_);
-        tmpColor.setAlpha(m_slider_->value());
+        tmpColor.setAlpha(value());
         return tmpColor;
     }
 
-    void ColorAlphaBar::SetValue(int alpha) const
+    void ColorAlphaBar::SetValue(int alpha)
     {
-        m_slider_->setValue(alpha);
+        setValue(alpha);
     }
 
-    void ColorAlphaBar::resizeEvent(QResizeEvent *)
+    void ColorAlphaBar::SetModel(ColorModel *model)
     {
-        m_checker_->setGeometry(0, (height() - m_groove_height_) / 2, width(), m_groove_height_);
+        if (m_model_ == model)
+            return;
+
+        if (m_model_)
+            disconnect(m_model_, nullptr, this, nullptr);
+
+        m_model_ = model;
+        if (m_model_) {
+            connect(m_model_, &ColorModel::sig_changed, this, &ColorAlphaBar::slot_modelChanged);
+            slot_modelChanged(ColorModel::AllFields);
+        }
+    }
+
+    void ColorAlphaBar::slot_modelChanged(ColorModel::Fields fields)
+    {
+        if (fields & (ColorModel::Hue | ColorModel::SaturationValue))
+            applyColor(m_model_->Color());
+
+        if (fields & ColorModel::Alpha) {
+            m_syncing_ = true;
+            setValue(m_model_->Alpha());
+            m_syncing_ = false;
+        }
+    }
+
+    void ColorAlphaBar::applyColor(const QColor &color)
+    {
+        m_color_ = color;
+        m_color_.setAlpha(255);
+
+        QColor tmp_color(color);
+        tmp_color.setAlpha(0);
+
+        // 仅当端点颜色变化时才重建槽体缓存
+        SetStops({ QGradientStop(0, tmp_color), QGradientStop(1, m_color_) });
     }
 
     ColorWorkbench::ColorWorkbench(QWidget *parent)
@@ -346,6 +1435,11 @@ namespace Custom_Control
             m_hsv_bar_->deleteLater();
         }
 
+        if (m_wheel_) {
+            m_wheel_->disconnect();
+            m_wheel_->deleteLater();
+        }
+
         if (m_canvas_) {
             m_canvas_->disconnect();
             m_canvas_->deleteLater();
@@ -375,30 +1469,26 @@ namespace Custom_Control
         if (m_preview_show_btn_)
             m_preview_show_btn_->deleteLater();
 
-        if (m_checker_)
-            m_checker_->deleteLater();
-
     }
 
     void ColorWorkbench::init()
     {
+        m_model_ = new ColorModel(this);
         initUI();
         init_connection();
     }
 
     void ColorWorkbench::initUI()
     {
-        setFixedSize(320, 280);
+        setFixedSize(320, 304);
         setAttribute(Qt::WA_StyledBackground);
         setAttribute(Qt::WA_Hover);
         setObjectName("workbench");
         setStyleSheet("#workbench{background-color:white; border:1px solid rgb(245,245,245); border-radius: 6px;}");
 
-        m_preview_show_btn_ = new QPushButton();
+        m_preview_show_btn_ = new ColorSwatch();
         m_preview_show_btn_->setFixedSize(QSize(32, 32));
 
-        m_checker_ = new ColorChecker(this);
-
         m_canvas_ = new ColorSVCanvas(this);
         m_canvas_->setFixedSize(300, 180);
 
@@ -410,6 +1500,15 @@ namespace Custom_Control
 
         m_line_edit_ = new QLineEdit(this);
 
+        // 最接近的颜色名显示在输入框内右侧，不接收鼠标事件
+        m_name_lab_ = new QLabel(m_line_edit_);
+        m_name_lab_->setAttribute(Qt::WA_TransparentForMouseEvents);
+        m_name_lab_->setStyleSheet("color:#9a9a9a;");
+        QHBoxLayout *name_layout = new QHBoxLayout(m_line_edit_);
+        name_layout->setContentsMargins(0, 0, 4, 0);
+        name_layout->addStretch();
+        name_layout->addWidget(m_name_lab_);
+
         m_cancel_btn_ = new HDBasePushButton(this);
         m_cancel_btn_->setObjectName("cancel");
         m_cancel_btn_->setText(tr("cancel"));
@@ -444,95 +1543,139 @@ namespace Custom_Control
         m_huebar_layout_->addLayout(m_adjust_vlayout_);
         m_huebar_layout_->addWidget(m_preview_show_btn_, Qt::AlignCenter);
 
+        // 最近使用的颜色，从新到旧，点击即选用
+        m_recent_layout_ = new QHBoxLayout;
+        m_recent_layout_->setContentsMargins(m_canvas_->Margin(), 0, 0, 0);
+        m_recent_layout_->setSpacing(4);
+        for (int i = 0; i < kRecentSwatchCount; ++i) {
+            ColorSwatch *swatch = new ColorSwatch(this);
+            swatch->setFixedSize(16, 16);
+            swatch->hide();
+            m_recent_layout_->addWidget(swatch);
+            m_recent_swatches_.append(swatch);
+        }
+        m_recent_layout_->addStretch();
+
         m_main_layout_->addLayout(m_huebar_layout_, 1, 0);
-        m_main_layout_->addLayout(m_handle_layout_, 2, 0, 1, 2);
+        m_main_layout_->addLayout(m_recent_layout_, 2, 0, 1, 2);
+        m_main_layout_->addLayout(m_handle_layout_, 3, 0, 1, 2);
     }
 
     void ColorWorkbench::init_connection()
     {
-        connect(m_confirm_btn_, &QPushButton::clicked, this, [this] {
-            emit sig_confirmed(m_alpha_slider_->Color());
-            });
+        connect(m_confirm_btn_, &QPushButton::clicked, this, &ColorWorkbench::confirm);
 
         connect(m_cancel_btn_, &QPushButton::clicked, this, [this] {
             emit sig_canceled();
+            reject();
             });
 
-        connect(m_hsv_bar_, &ColorHueBar::sig_valueChanged, this, [this](int val) {
-            m_canvas_->SetHue(val);
-            });
-        connect(m_canvas_, &ColorSVCanvas::sig_colorChanged, this, [this](const QColor &color) {
-            m_alpha_slider_->SetColor(color);
+        // 子控件只与模型交互，一次修改每个视图只收到一次通知
+        m_canvas_->SetModel(m_model_);
+        m_hsv_bar_->SetModel(m_model_);
+        m_alpha_slider_->SetModel(m_model_);
+        connect(m_model_, &ColorModel::sig_changed, this, &ColorWorkbench::slot_modelChanged);
+
+        connect(m_canvas_, &ColorSVCanvas::sig_doubleClick, this, &ColorWorkbench::confirm);
+        // OkLch色相不在模型中，由色相条直接交给画布
+        connect(m_hsv_bar_, &ColorHueBar::sig_valueChanged, this, [this](int hue) {
+            if (m_canvas_->PlaneMode() == ColorPlaneMode::OkLch)
+                m_canvas_->SetHue(hue);
             });
-        connect(m_canvas_, &ColorSVCanvas::sig_doubleClick, this, [this]() {
-            emit sig_confirmed(m_alpha_slider_->Color());
-            });
-        connect(m_alpha_slider_, &ColorAlphaBar::sig_colorChanged, this, &ColorWorkbench::slot_colorDisplay);
         connect(m_line_edit_, &QLineEdit::textEdited, this, &ColorWorkbench::slot_colorEdit);
+
+        for (ColorSwatch *swatch : m_recent_swatches_) {
+            connect(swatch, &QAbstractButton::clicked, this, [this, swatch] {
+                m_model_->SetColor(swatch->Color());
+                });
+        }
+        connect(RecentColorStore::Instance(), &RecentColorStore::sig_changed, this, &ColorWorkbench::refreshRecentColors);
+
         this->installEventFilter(this);
     }
 
+    void ColorWorkbench::refreshRecentColors()
+    {
+        RecentColorStore *store = RecentColorStore::Instance();
+        const quint64 sequence = store->Sequence();
+        if (sequence == m_recent_sequence_)
+            return;
+
+        m_recent_sequence_ = sequence;
+        const QVector<QColor> colors = store->Colors(m_recent_swatches_.size());
+        for (int i = 0; i < m_recent_swatches_.size(); ++i) {
+            ColorSwatch *swatch = m_recent_swatches_.at(i);
+            if (i < colors.size()) {
+                swatch->SetColor(colors.at(i));
+                swatch->setToolTip(colors.at(i).name(QColor::HexArgb));
+                swatch->show();
+            }
+            else {
+                swatch->hide();
+            }
+        }
+    }
+
     void ColorWorkbench::SetColor(QColor color) const
     {
-        m_hsv_bar_->SetValue(color.hsvHue());
-        m_canvas_->SetSaturationValue(color.hsvSaturation(), color.value());
-        m_alpha_slider_->SetValue(color.alpha());
+        m_model_->SetColor(color);
     }
 
     QColor ColorWorkbench::GetColor() const
     {
-        return m_alpha_slider_->Color();
+        return m_model_->Color();
     }
 
-    QColor ColorWorkbench::colorFromStr(QString str)
+    ColorModel *ColorWorkbench::Model() const
     {
-        QColor color(str);
-        if (!color.isValid()) {
-            QString tmpStr = str;
-            QRegularExpression rx("[^\\d+^,^.]");
-            if (str.contains(rx)) {
-                tmpStr.remove(rx);
-            }
-            if (!tmpStr.isEmpty()) {
-                QStringList strList = tmpStr.split(",");
-                if (str.contains("rgba") && strList.count() == 4) {
-                    color.setRgb(strList.at(0).toInt(), strList.at(1).toInt(), strList.at(2).toInt());
-                    if (strList.at(3).toDouble() > 1) {
-                        color.setAlpha(strList.at(3).toInt());
-                    }
-                    else {
-                        color.setAlphaF(strList.at(3).toDouble());
-                    }
-                }
-                else if (str.contains("rgb") && strList.count() == 3) {
-                    color.setRgb(strList.at(0).toInt(), strList.at(1).toInt(), strList.at(2).toInt());
-                }
-                else if (str.contains("hsv") && strList.count() == 3) {
-                    color.setHsv(strList.at(0).toInt(), strList.at(1).toInt(), strList.at(2).toInt());
-                }
-            }
-        }
+        return m_model_;
+    }
 
-        return color;
+    void ColorWorkbench::SetPlaneMode(ColorPlaneMode mode)
+    {
+        m_canvas_->SetPlaneMode(mode);
+        m_hsv_bar_->SetPlaneMode(mode);
     }
 
-    void ColorWorkbench::setPreviewColor(const QColor &color)
+    ColorPlaneMode ColorWorkbench::PlaneMode() const
     {
-        if (m_preview_show_btn_) {
-            m_preview_show_btn_->setStyleSheet(QString("QPushButton{border:1px solid %1; background-color:%2}")
-                .arg(QColor(152, 152, 152).name())
-                .arg(color.name(QColor::HexArgb)));
+        return m_canvas_->PlaneMode();
+    }
+
+    void ColorWorkbench::SetPickerLayout(WorkbenchLayout layout)
+    {
+        if (layout == WorkbenchLayout::Wheel && !m_wheel_) {
+            m_wheel_ = new ColorWheel(this);
+            m_wheel_->setFixedSize(m_canvas_->size());
+            m_wheel_->SetModel(m_model_);
+            connect(m_wheel_, &ColorWheel::sig_doubleClick, this, &ColorWorkbench::confirm);
+            m_main_layout_->addWidget(m_wheel_, 0, 0);
         }
+
+        // 两种布局都观察同一个模型，切换时无需同步
+        const bool wheel = layout == WorkbenchLayout::Wheel;
+        m_canvas_->setVisible(!wheel);
+        m_hsv_bar_->setVisible(!wheel);
+        if (m_wheel_)
+            m_wheel_->setVisible(wheel);
     }
 
-    void ColorWorkbench::resizeEvent(QResizeEvent *event)
+    WorkbenchLayout ColorWorkbench::PickerLayout() const
     {
-        if (m_checker_ && m_preview_show_btn_)
-            m_checker_->setGeometry(m_preview_show_btn_->geometry());
+        return m_wheel_ && !m_wheel_->isHidden() ? WorkbenchLayout::Wheel : WorkbenchLayout::Plane;
+    }
+
+    void ColorWorkbench::setPreviewColor(const QColor &color)
+    {
+        if (m_preview_show_btn_)
+            m_preview_show_btn_->SetColor(color);
     }
 
     bool ColorWorkbench::eventFilter(QObject *watched, QEvent *event)
     {
+        if (watched == this && event->type() == QEvent::Show)
+            refreshRecentColors();
+
         if (watched == this) {
             if (event->type() == QEvent::HoverEnter) {
                 this->setCursor(Qt::ArrowCursor);
@@ -550,53 +1693,76 @@ namespace Custom_Control
         return true;
     }
 
+    void ColorWorkbench::slot_modelChanged(ColorModel::Fields)
+    {
+        slot_colorDisplay(m_model_->Color());
+    }
+
     void ColorWorkbench::slot_colorDisplay(const QColor &color)
     {
-        QRegularExpression reg("(\\.){0,1}0+$");// 去除末尾0
-        m_line_edit_->setText(QString("rgba(%1, %2, %3, %4)")
-            .arg(color.red())
-            .arg(color.green())
-            .arg(color.blue())
-            .arg(QString::number(color.alphaF(), 'f', 2).replace(reg, "")));
+        // 正在编辑的文本不回写
+        if (!m_editing_) {
+            static const QRegularExpression reg("(\\.){0,1}0+$");// 去除末尾0
+            m_line_edit_->setText(QString("rgba(%1, %2, %3, %4)")
+                .arg(color.red())
+                .arg(color.green())
+                .arg(color.blue())
+                .arg(QString::number(color.alphaF(), 'f', 2).replace(reg, "")));
+        }
         // set preview color
         setPreviewColor(color);
+        updateNameHint(color);
 
         emit sig_colorChanged(color);
     }
 
-    void ColorWorkbench::slot_colorEdit(const QString &text)
+    void ColorWorkbench::updateNameHint(const QColor &color)
+    {
+        if (!m_name_lab_)
+            return;
+
+        // 非精确匹配时加'~'前缀
+        const NamedColor *named = NamedColorIndex::Shared().Nearest(color.rgb());
+        QString text;
+        if (named)
+            text = (named->rgb & RGB_MASK) == (color.rgb() & RGB_MASK) ? named->name : QStringLiteral("~") + named->name;
+
+        m_name_lab_->setText(text);
+        m_line_edit_->setTextMargins(0, 0, text.isEmpty() ? 0 : m_name_lab_->sizeHint().width() + 4, 0);
+    }
+
+    void ColorWorkbench::confirm()
     {
-        const QColor color = colorFromStr(text);
-        if (color.isValid()) {
-            disconnect(m_alpha_slider_, &ColorAlphaBar::sig_colorChanged, this, &ColorWorkbench::slot_colorDisplay);
-            SetColor(color);
-            connect(m_alpha_slider_, &ColorAlphaBar::sig_colorChanged, this, &ColorWorkbench::slot_colorDisplay);
-            // set preview color
-            setPreviewColor(color);
+        // 以Accepted结束，finished的接收方据此提交颜色
+        emit sig_confirmed(GetColor());
+        accept();
+    }
+
+    void ColorWorkbench::ResetInput()
+    {
+        m_editing_ = false;
+        slot_colorDisplay(m_model_->Color());
+        m_line_edit_->deselect();
+        m_line_edit_->setCursorPosition(0);
+    }
 
-            emit sig_colorChanged(color);
+    void ColorWorkbench::slot_colorEdit(const QString &text)
+    {
+        const ColorParseResult result = ParseColor(text);
+        if (result.IsValid()) {
+            m_editing_ = true;
+            SetColor(result.color);
+            m_editing_ = false;
         }
     }
 
     ColorPalette::ColorPalette(QWidget *parent)
         : QLabel(parent)
     {
-        m_checker_ = new ColorChecker(this);
-
-        m_popup_ = new ColorWorkbench(this);
-        connect(m_popup_, &ColorWorkbench::sig_colorChanged, this, &ColorPalette::slot_colorChanged);
-        connect(m_popup_, &QDialog::finished, this, [this](int result) {
-            if (result == QDialog::Accepted) {
-                m_ori_color_ = m_cur_color_;
-            }
-            else {
-                setColor(m_ori_color_);
-            }
-            });
-
-        m_button_ = new QPushButton("v", this);
+        m_button_ = new ColorSwatch(this);
+        m_button_->setText("v");
         m_button_->setFixedSize(30, 30);
-        connect(m_button_, &QPushButton::pressed, this, &ColorPalette::slot_showPopup);
+        connect(m_button_, &QAbstractButton::pressed, this, &ColorPalette::slot_showPopup);
 
         setFixedSize(40, 40);
         setStyleSheet(QString("QLabel{border:1px solid %1; border-radius: 4px; background-color: %2;}")
@@ -612,13 +1778,9 @@ namespace Custom_Control
     ColorPalette::~ColorPalette()
     {
         if (m_popup_) {
-            m_popup_->disconnect();
-            m_popup_->deleteLater();
-        }
-
-        if (m_checker_) {
-            m_checker_->disconnect();
-            m_checker_->deleteLater();
+            ColorWorkbench *popup = m_popup_;
+            unbindPopup();
+            popup->close();
         }
 
         if (m_button_) {
@@ -631,23 +1793,63 @@ namespace Custom_Control
 
     }
 
-    void ColorPalette::resizeEvent(QResizeEvent *)
+    void ColorPalette::SetLivePreview(bool enable)
+    {
+        m_live_preview_ = enable;
+    }
+
+    bool ColorPalette::LivePreview() const
     {
-        m_checker_->setGeometry(m_button_->geometry());
+        return m_live_preview_;
     }
 
     void ColorPalette::setColor(const QColor &color)
     {
         m_cur_color_ = color;
-        m_button_->setStyleSheet(QString("QPushButton{border:1px solid %1; background-color:%2}")
-            .arg(QColor(152, 152, 152).name())
-            .arg(color.name(QColor::HexArgb)));
+        m_button_->SetColor(color);
+    }
+
+    void ColorPalette::bindPopup()
+    {
+        // 弹出框仍绑定在其他调色板上时先解除
+        QPointer<ColorPalette> &owner = popupOwner();
+        if (owner && owner != this)
+            owner->unbindPopup();
+
+        owner = this;
+        m_popup_ = sharedWorkbench();
+
+        // 继承本窗口的调色板、样式表与瞬态父窗口；setParent会清除窗口标志，需一并传入
+        QWidget *host = window();
+        if (m_popup_->parentWidget() != host)
+            m_popup_->setParent(host, m_popup_->windowFlags());
+        m_popup_connections_.append(connect(m_popup_.data(), &ColorWorkbench::sig_colorChanged,
+            this, &ColorPalette::slot_colorChanged));
+        m_popup_connections_.append(connect(m_popup_.data(), &QDialog::finished,
+            this, &ColorPalette::slot_popupFinished));
+    }
+
+    void ColorPalette::unbindPopup()
+    {
+        for (const QMetaObject::Connection &connection : m_popup_connections_)
+            disconnect(connection);
+        m_popup_connections_.clear();
+        m_popup_ = nullptr;
+
+        QPointer<ColorPalette> &owner = popupOwner();
+        if (owner == this)
+            owner = nullptr;
     }
 
     void ColorPalette::slot_showPopup()
     {
+        if (!m_popup_)
+            bindPopup();
+
         m_ori_color_ = m_cur_color_;
         m_popup_->SetColor(m_ori_color_);
+        // 上一个调色板留下的未提交输入不带到本次
+        m_popup_->ResetInput();
 
         QPoint tmpPos = mapToGlobal(m_button_->geometry().center());
         tmpPos += QPoint(-m_popup_->width() / 2, m_button_->height() / 2 + 5);
@@ -656,11 +1858,31 @@ namespace Custom_Control
         m_popup_->open();
     }
 
+    void ColorPalette::slot_popupFinished(int result)
+    {
+        if (result == QDialog::Accepted) {
+            if (m_popup_)
+                m_cur_color_ = m_popup_->GetColor();
+            m_ori_color_ = m_cur_color_;
+            m_button_->SetColor(m_cur_color_);
+            RecentColorStore::Instance()->Append(m_cur_color_);
+        }
+        else {
+            setColor(m_ori_color_);
+        }
+
+        unbindPopup();
+    }
+
     void ColorPalette::slot_colorChanged(const QColor &color)
     {
-        if (m_popup_->isVisible()) {
+        if (!m_popup_ || !m_popup_->isVisible())
+            return;
+
+        if (m_live_preview_)
             setColor(color);
-        }
+        else
+            m_cur_color_ = color;
     }
 
 
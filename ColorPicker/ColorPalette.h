@@ -2,17 +2,93 @@
 
 #include <QWidget>
 #include <QColor>
+#include <QImage>
 #include <QSlider>
+#include <QAbstractSlider>
+#include <QAbstractButton>
+#include <QPixmap>
+#include <QBrush>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QDialog>
 #include <QLabel>
 #include <QLineEdit>
 #include <QHBoxLayout>
+#include <QVector>
+#include <QPointer>
+#include <memory>
 
 #include "HDBasePushButton.h"
+#include "ColorModel.h"
 
 namespace Custom_Control
 {
-    class ColorHueBar : public QWidget
+    // 颜色平面与色相条的坐标系
+    //   Hsv    x为饱和度，y为明度，色相为HSV色相
+    //   OkLch  x为色度，y为感知亮度，色相为OKLCH色相，同一行的颜色亮度看起来一致
+    enum class ColorPlaneMode
+    {
+        Hsv,
+        OkLch
+    };
+
+    // ColorWorkbench取色区域的布局：SV平面加色相条，或色相环加内接SV方块
+    enum class WorkbenchLayout
+    {
+        Plane,
+        Wheel
+    };
+
+    // 自绘渐变滑块：槽体渲染后缓存，颜色变化只需使缓存失效，不经过样式表
+    class GradientSlider : public QAbstractSlider
+    {
+        Q_OBJECT
+
+    public:
+        explicit GradientSlider(QWidget *parent = nullptr);
+        ~GradientSlider() override;
+
+        // 渐变端点按槽体从左到右的位置给出
+        void SetStops(const QGradientStops &stops);
+        QGradientStops Stops() const;
+
+        // 在渐变下方绘制棋盘格，用于显示透明度
+        void SetCheckerboard(bool enable);
+        bool Checkerboard() const;
+
+        void SetGrooveHeight(int height);
+        int GrooveHeight() const;
+
+        QSize sizeHint() const override;
+
+    protected:
+        void paintEvent(QPaintEvent *ev) Q_DECL_OVERRIDE;
+        void resizeEvent(QResizeEvent *ev) Q_DECL_OVERRIDE;
+        void mousePressEvent(QMouseEvent *ev) Q_DECL_OVERRIDE;
+        void mouseMoveEvent(QMouseEvent *ev) Q_DECL_OVERRIDE;
+        void mouseReleaseEvent(QMouseEvent *ev) Q_DECL_OVERRIDE;
+        void showEvent(QShowEvent *ev) Q_DECL_OVERRIDE;
+
+    private:
+        QRect grooveRect() const;
+        QRect handleRect() const;
+        int valueFromX(int x) const;
+        void invalidateGroove();
+        void rebuildGroove();
+
+    private:
+        QGradientStops m_stops_;
+        bool m_checkerboard_ = false;
+        int m_groove_height_;
+        int m_handle_width_;
+        int m_checker_size_;
+
+        // 按当前DPR渲染，换屏后重建
+        QPixmap m_groove_cache_;
+        QMetaObject::Connection m_screen_connection_;
+    };
+
+    class ColorHueBar : public GradientSlider
     {
         Q_OBJECT
 
@@ -20,15 +96,29 @@ namespace Custom_Control
         explicit ColorHueBar(QWidget *parent = nullptr);
         ~ColorHueBar() override;
 
-        void SetValue(int val) const;
+        void SetValue(int val);
         int Value() const;
 
+        // 绑定后色相与模型双向同步
+        // OkLch模式下色相不写回模型，只通过sig_valueChanged交给ColorSVCanvas
+        void SetModel(ColorModel *model);
+
+        void SetPlaneMode(ColorPlaneMode mode);
+        ColorPlaneMode PlaneMode() const;
+
     signals:
         void sig_valueChanged(int val);
 
+    private slots:
+        void slot_modelChanged(Custom_Control::ColorModel::Fields fields);
+
     private:
-        QSlider *m_slider_ { nullptr };
-        QHBoxLayout *m_main_hloayout_ { nullptr };
+        void updateStops();
+
+    private:
+        ColorModel *m_model_ { nullptr };
+        bool m_syncing_ = false;
+        ColorPlaneMode m_mode_ = ColorPlaneMode::Hsv;
     };
 
     class ColorSVCanvas : public QWidget
@@ -46,20 +136,45 @@ namespace Custom_Control
         QRect AvailabilityRect() const;
         int Margin() const;
 
+        // 最近一次绘制回填的平面设备像素数，只计入脏区域与AvailabilityRect的交集
+        qint64 LastPaintPixels() const;
+
+        // 绑定后色相、饱和度与明度与模型双向同步
+        void SetModel(ColorModel *model);
+
+        // OkLch模式下SetHue接收OKLCH色相，SetSaturationValue的两个分量依次为色度与亮度(0~255)
+        void SetPlaneMode(ColorPlaneMode mode);
+        ColorPlaneMode PlaneMode() const;
+
     signals:
         void sig_colorChanged(const QColor &color);
         void sig_doubleClick();
 
+    private slots:
+        void slot_modelChanged(Custom_Control::ColorModel::Fields fields);
+
     protected:
         void paintEvent(QPaintEvent *ev) Q_DECL_OVERRIDE;
         void resizeEvent(QResizeEvent *ev) Q_DECL_OVERRIDE;
+        void showEvent(QShowEvent *ev) Q_DECL_OVERRIDE;
         bool eventFilter(QObject *obj, QEvent *ev) Q_DECL_OVERRIDE;
 
     private:
+        QImage planeImage() const;
         QPoint valueFromPos(QPoint &pos) const;
         QPoint posFromValue(QPoint &val) const;
 
+        QRect ringRect(const QPoint &pos) const;
+        QPoint clampToRect(const QPoint &pos) const;
+        int frameInterval() const;
+        void setCursorPos(const QPoint &pos);
+        void queueCursorPos(const QPoint &pos);
+        void flushCursorPos(bool is_final);
+        void publishColor();
+        void syncFromModel(ColorModel::Fields fields);
+
     private:
+        ColorPlaneMode m_mode_ = ColorPlaneMode::Hsv;
         int m_margin_;
         int m_radius_;
         int m_saturation_max_;
@@ -67,6 +182,101 @@ namespace Custom_Control
 
         int m_hue_;
         QPoint m_pos_ = { 0 ,0 };
+        qint64 m_last_paint_pixels_ = 0;
+
+        // 拖动时的位置合并：每帧最多一次重绘和一次sig_colorChanged
+        bool m_dragging_ = false;
+        bool m_has_pending_pos_ = false;
+        QPoint m_pending_pos_;
+        QTimer *m_frame_timer_ { nullptr };
+        QElapsedTimer m_frame_clock_;
+
+        ColorModel *m_model_ { nullptr };
+        bool m_syncing_ = false;
+
+        // 当前平面光栅及其缓存键(含DPR)，换屏后丢弃
+        mutable QImage m_plane_;
+        mutable quint64 m_plane_key_ = 0;
+        QMetaObject::Connection m_screen_connection_;
+    };
+
+    struct WheelTable;
+
+    // 色相环与内接的SV方块，方块与ColorSVCanvas共用同一份平面缓存
+    // 每个设备像素的色相及色相环的覆盖率按尺寸预先算好并在实例间共享，绘制与命中测试只查表
+    class ColorWheel : public QWidget
+    {
+        Q_OBJECT
+    public:
+        explicit ColorWheel(QWidget *parent = nullptr);
+        ~ColorWheel() override;
+
+        bool SetHue(int hue);
+        int Hue() const;
+
+        bool SetSaturationValue(int saturation, int value);
+
+        QColor Color() const;
+
+        // 色相环宽度(逻辑像素)
+        void SetRingWidth(int width);
+        int RingWidth() const;
+
+        // 绑定后色相、饱和度与明度与模型双向同步
+        void SetModel(ColorModel *model);
+
+        QSize sizeHint() const override;
+
+    signals:
+        void sig_colorChanged(const QColor &color);
+        void sig_doubleClick();
+
+    private slots:
+        void slot_modelChanged(Custom_Control::ColorModel::Fields fields);
+
+    protected:
+        void paintEvent(QPaintEvent *ev) Q_DECL_OVERRIDE;
+        void resizeEvent(QResizeEvent *ev) Q_DECL_OVERRIDE;
+        void showEvent(QShowEvent *ev) Q_DECL_OVERRIDE;
+        void mousePressEvent(QMouseEvent *ev) Q_DECL_OVERRIDE;
+        void mouseMoveEvent(QMouseEvent *ev) Q_DECL_OVERRIDE;
+        void mouseReleaseEvent(QMouseEvent *ev) Q_DECL_OVERRIDE;
+        void mouseDoubleClickEvent(QMouseEvent *ev) Q_DECL_OVERRIDE;
+
+    private:
+        enum class DragTarget
+        {
+            None,
+            Ring,
+            Plane
+        };
+
+        QRect wheelRect() const;
+        QRect planeRect() const;
+        const WheelTable &table() const;
+        bool ringContains(const QPoint &pos) const;
+        int hueAt(const QPoint &pos) const;
+        QPoint valueFromPos(const QPoint &pos) const;
+        QPoint posFromValue(int saturation, int value) const;
+        QPointF hueMarkerPos() const;
+        void dragTo(const QPoint &pos);
+        void publishColor();
+
+    private:
+        int m_margin_;
+        int m_ring_width_;
+        int m_radius_;
+
+        int m_hue_ = 0;
+        int m_saturation_ = 255;
+        int m_value_ = 255;
+        DragTarget m_drag_ = DragTarget::None;
+
+        mutable std::shared_ptr<const WheelTable> m_table_;
+        QMetaObject::Connection m_screen_connection_;
+
+        ColorModel *m_model_ { nullptr };
+        bool m_syncing_ = false;
     };
 
     class ColorChecker : public QWidget
@@ -79,12 +289,42 @@ namespace Custom_Control
 
     protected:
         void paintEvent(QPaintEvent *ev) Q_DECL_OVERRIDE;
+        void showEvent(QShowEvent *ev) Q_DECL_OVERRIDE;
 
     private:
         int m_checker_size_;
+        QMetaObject::Connection m_screen_connection_;
     };
 
-    class ColorAlphaBar : public QWidget
+    // 自绘色块：棋盘格底纹上叠加颜色，颜色变化只重绘自身，不经过样式表
+    class ColorSwatch : public QAbstractButton
+    {
+        Q_OBJECT
+
+    public:
+        explicit ColorSwatch(QWidget *parent = nullptr);
+        ~ColorSwatch() override;
+
+        void SetColor(const QColor &color);
+        QColor Color() const;
+
+        void SetBorderColor(const QColor &color);
+        QColor BorderColor() const;
+
+        QSize sizeHint() const override;
+
+    protected:
+        void paintEvent(QPaintEvent *ev) Q_DECL_OVERRIDE;
+        void showEvent(QShowEvent *ev) Q_DECL_OVERRIDE;
+
+    private:
+        QColor m_color_;
+        QColor m_border_color_;
+        int m_checker_size_;
+        QMetaObject::Connection m_screen_connection_;
+    };
+
+    class ColorAlphaBar : public GradientSlider
     {
         Q_OBJECT
     public:
@@ -94,20 +334,24 @@ namespace Custom_Control
         void SetColor(QColor color);
         QColor Color() const;
 
-        void SetValue(int alpha) const;
+        void SetValue(int alpha);
+
+        // 绑定后透明度与模型双向同步，渐变端点跟随模型颜色
+        void SetModel(ColorModel *model);
 
     signals:
         void sig_colorChanged(const QColor &color);
 
-    protected:
-        void resizeEvent(QResizeEvent *ev) Q_DECL_OVERRIDE;
+    private slots:
+        void slot_modelChanged(Custom_Control::ColorModel::Fields fields);
+
+    private:
+        void applyColor(const QColor &color);
 
     private:
-        ColorChecker *m_checker_ { nullptr };
-        QSlider *m_slider_ { nullptr };
         QColor m_color_;
-        QVBoxLayout *m_v_box_layout_ { nullptr };
-        int m_groove_height_;
+        ColorModel *m_model_ { nullptr };
+        bool m_syncing_ = false;
     };
 
     class ColorWorkbench : public QDialog
@@ -121,6 +365,18 @@ namespace Custom_Control
 
         QColor GetColor() const;
 
+        ColorModel *Model() const;
+
+        // 丢弃输入框中未生效的文本，按当前颜色重新显示
+        void ResetInput();
+
+        void SetPlaneMode(ColorPlaneMode mode);
+        ColorPlaneMode PlaneMode() const;
+
+        // 色相环布局下色相条隐藏，色环首次切换时才创建
+        void SetPickerLayout(WorkbenchLayout layout);
+        WorkbenchLayout PickerLayout() const;
+
     signals:
         void sig_colorChanged(const QColor &color);
 
@@ -130,27 +386,34 @@ namespace Custom_Control
         void sig_hover(bool is_hover);
 
     private:
-        QColor colorFromStr(QString str);
+        void confirm();
         void setPreviewColor(const QColor& color);
+        void updateNameHint(const QColor &color);
+        // 最近使用颜色的序号未变时不重建色块；其他进程的追加没有通知，打开时检查序号
+        void refreshRecentColors();
         void init();
         void initUI();
         void init_connection();
 
     protected:
-        void resizeEvent(QResizeEvent* event) override;
         bool eventFilter(QObject* watched, QEvent* event) override;
 
     private slots:
+        void slot_modelChanged(Custom_Control::ColorModel::Fields fields);
         void slot_colorDisplay(const QColor &color);
         void slot_colorEdit(const QString &text);
 
     private:
+        ColorModel *m_model_ { nullptr };
+        bool m_editing_ = false;
+
         ColorSVCanvas *m_canvas_ { nullptr };
+        ColorWheel *m_wheel_ { nullptr };
         ColorHueBar *m_hsv_bar_ { nullptr };
         ColorAlphaBar *m_alpha_slider_ { nullptr };
-        ColorChecker *m_checker_ { nullptr };
 
         QLineEdit *m_line_edit_ { nullptr };
+        QLabel *m_name_lab_ { nullptr };
         HDAbsPushButton *m_cancel_btn_ { nullptr };
         HDAbsPushButton *m_confirm_btn_ { nullptr };
 
@@ -159,7 +422,11 @@ namespace Custom_Control
         QVBoxLayout *m_adjust_vlayout_ { nullptr };
         QGridLayout *m_main_layout_ { nullptr };
 
-        QPushButton *m_preview_show_btn_ { nullptr };
+        ColorSwatch *m_preview_show_btn_ { nullptr };
+
+        QHBoxLayout *m_recent_layout_ { nullptr };
+        QVector<ColorSwatch *> m_recent_swatches_;
+        quint64 m_recent_sequence_ = ~quint64(0);
     };
 
     class ColorPalette : public QLabel
@@ -169,20 +436,27 @@ namespace Custom_Control
         explicit ColorPalette(QWidget *parent = nullptr);
         ~ColorPalette() override;
 
-    protected:
-        void resizeEvent(QResizeEvent *ev) Q_DECL_OVERRIDE;
+        // 开启时色块在弹出框拖动过程中实时跟随颜色，关闭时只在确认后更新
+        void SetLivePreview(bool enable);
+        bool LivePreview() const;
 
     private:
         void setColor(const QColor &color);
+        void bindPopup();
+        void unbindPopup();
 
     private slots:
         void slot_showPopup();
+        void slot_popupFinished(int result);
         void slot_colorChanged(const QColor &color);
 
     private:
-        QPushButton *m_button_ { nullptr };
-        ColorChecker *m_checker_ { nullptr };
-        ColorWorkbench *m_popup_ { nullptr };
+        ColorSwatch *m_button_ { nullptr };
+        bool m_live_preview_ = true;
+
+        // 所有调色板共享的弹出框，仅在本调色板打开期间绑定；可能随所在窗口先被销毁
+        QPointer<ColorWorkbench> m_popup_;
+        QVector<QMetaObject::Connection> m_popup_connections_;
 
         QColor m_cur_color_;
         QColor m_ori_color_;
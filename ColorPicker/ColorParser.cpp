@@ -0,0 +1,361 @@
+#include "ColorParser.h"
+#include <cmath>
+
+namespace Custom_Control
+{
+    namespace
+    {
+        enum class ColorFunction
+        {
+            Rgb,
+            Hsv,
+            Hsl
+        };
+
+        struct Number
+        {
+            double value = 0;
+            bool percent = false;
+            bool degree = false;
+            int pos = 0;
+        };
+
+        bool isSpace(char16_t ch)
+        {
+            return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f';
+        }
+
+        bool isDigit(char16_t ch)
+        {
+            return ch >= '0' && ch <= '9';
+        }
+
+        bool isLetter(char16_t ch)
+        {
+            return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+        }
+
+        int hexValue(char16_t ch)
+        {
+            if (ch >= '0' && ch <= '9')
+                return ch - '0';
+            if (ch >= 'a' && ch <= 'f')
+                return ch - 'a' + 10;
+            if (ch >= 'A' && ch <= 'F')
+                return ch - 'A' + 10;
+            return -1;
+        }
+
+        // ASCII大小写不敏感比较，literal须为小写
+        bool equalsIgnoreCase(QStringView view, const char *literal)
+        {
+            int i = 0;
+            for (; literal[i] != '\0'; ++i) {
+                if (i >= view.size())
+                    return false;
+
+                char16_t ch = view.at(i).unicode();
+                if (ch >= 'A' && ch <= 'Z')
+                    ch = char16_t(ch - 'A' + 'a');
+                if (ch != char16_t(literal[i]))
+                    return false;
+            }
+            return i == view.size();
+        }
+
+        class Scanner
+        {
+        public:
+            explicit Scanner(QStringView text)
+                : m_text_(text)
+            {
+            }
+
+            int Pos() const { return m_pos_; }
+            bool AtEnd() const { return m_pos_ >= m_text_.size(); }
+            char16_t Peek() const { return AtEnd() ? char16_t(0) : m_text_.at(m_pos_).unicode(); }
+            void Advance() { ++m_pos_; }
+            QStringView Slice(int from) const { return m_text_.mid(from, m_pos_ - from); }
+
+            void SkipSpaces()
+            {
+                while (!AtEnd() && isSpace(Peek()))
+                    ++m_pos_;
+            }
+
+            bool Accept(char16_t ch)
+            {
+                if (Peek() != ch)
+                    return false;
+                ++m_pos_;
+                return true;
+            }
+
+        private:
+            QStringView m_text_;
+            int m_pos_ = 0;
+        };
+
+        bool fail(ColorParseResult &result, ColorParseError error, int pos)
+        {
+            result.error = error;
+            result.error_pos = pos;
+            return false;
+        }
+
+        bool parseHex(Scanner &scanner, HexAlphaOrder hex_alpha, ColorParseResult &result)
+        {
+            const int hash_pos = scanner.Pos();
+            scanner.Advance();
+
+            int digits[8] = { 0 };
+            int count = 0;
+            for (int value = hexValue(scanner.Peek()); value >= 0; value = hexValue(scanner.Peek())) {
+                if (count == 8)
+                    return fail(result, ColorParseError::InvalidHexLength, hash_pos);
+
+                digits[count++] = value;
+                scanner.Advance();
+            }
+
+            if (!scanner.AtEnd() && !isSpace(scanner.Peek()))
+                return fail(result, ColorParseError::UnexpectedCharacter, scanner.Pos());
+
+            int channels[4] = { 0, 0, 0, 255 };
+            switch (count) {
+            case 3:
+            case 4:
+                for (int i = 0; i < count; ++i)
+                    channels[i] = digits[i] * 17;
+                break;
+            case 6:
+            case 8:
+                for (int i = 0; i < count / 2; ++i)
+                    channels[i] = digits[i * 2] * 16 + digits[i * 2 + 1];
+                break;
+            default:
+                return fail(result, ColorParseError::InvalidHexLength, hash_pos);
+            }
+
+            // #argb、#aarrggbb：带透明度时第一个分量是透明度
+            if (hex_alpha == HexAlphaOrder::First && (count == 4 || count == 8)) {
+                result.color = QColor(channels[1], channels[2], channels[3], channels[0]);
+                return true;
+            }
+
+            result.color = QColor(channels[0], channels[1], channels[2], channels[3]);
+            return true;
+        }
+
+        bool parseNumber(Scanner &scanner, Number &number, ColorParseResult &result)
+        {
+            number = Number();
+            number.pos = scanner.Pos();
+
+            bool negative = false;
+            if (scanner.Accept('-'))
+                negative = true;
+            else
+                scanner.Accept('+');
+
+            double value = 0;
+            int digit_count = 0;
+            while (isDigit(scanner.Peek())) {
+                value = value * 10 + (scanner.Peek() - '0');
+                ++digit_count;
+                scanner.Advance();
+            }
+
+            if (scanner.Accept('.')) {
+                double scale = 0.1;
+                while (isDigit(scanner.Peek())) {
+                    value += (scanner.Peek() - '0') * scale;
+                    scale *= 0.1;
+                    ++digit_count;
+                    scanner.Advance();
+                }
+            }
+
+            if (digit_count == 0)
+                return fail(result, ColorParseError::InvalidNumber, number.pos);
+
+            number.value = negative ? -value : value;
+
+            // 单位：百分号或deg
+            if (scanner.Accept('%')) {
+                number.percent = true;
+            }
+            else if (isLetter(scanner.Peek())) {
+                const int unit_pos = scanner.Pos();
+                while (isLetter(scanner.Peek()))
+                    scanner.Advance();
+
+                if (!equalsIgnoreCase(scanner.Slice(unit_pos), "deg"))
+                    return fail(result, ColorParseError::UnexpectedCharacter, unit_pos);
+                number.degree = true;
+            }
+
+            return true;
+        }
+
+        // 色相：角度，可带deg，超出一周时取模
+        bool hueComponent(const Number &number, double &hue, ColorParseResult &result)
+        {
+            if (number.percent)
+                return fail(result, ColorParseError::UnexpectedCharacter, number.pos);
+
+            hue = std::fmod(number.value, 360.0);
+            if (hue < 0)
+                hue += 360.0;
+            return true;
+        }
+
+        // 归一化到0~1：百分比或0~max的数值
+        bool unitComponent(const Number &number, double max, double &unit, ColorParseResult &result)
+        {
+            if (number.degree)
+                return fail(result, ColorParseError::UnexpectedCharacter, number.pos);
+
+            unit = number.percent ? number.value / 100.0 : number.value / max;
+            if (unit < 0.0 || unit > 1.0)
+                return fail(result, ColorParseError::OutOfRange, number.pos);
+            return true;
+        }
+
+        bool alphaComponent(const Number &number, double &alpha, ColorParseResult &result)
+        {
+            if (number.percent || number.value <= 1.0)
+                return unitComponent(number, 1.0, alpha, result);
+
+            // 旧格式rgba(r, g, b, 0~255)
+            return unitComponent(number, 255.0, alpha, result);
+        }
+
+        bool parseFunction(Scanner &scanner, QStringView name, int name_pos, ColorParseResult &result)
+        {
+            ColorFunction function;
+            if (equalsIgnoreCase(name, "rgb") || equalsIgnoreCase(name, "rgba"))
+                function = ColorFunction::Rgb;
+            else if (equalsIgnoreCase(name, "hsv") || equalsIgnoreCase(name, "hsva"))
+                function = ColorFunction::Hsv;
+            else if (equalsIgnoreCase(name, "hsl") || equalsIgnoreCase(name, "hsla"))
+                function = ColorFunction::Hsl;
+            else
+                return fail(result, ColorParseError::UnknownFunction, name_pos);
+
+            // 跳过'('
+            scanner.Advance();
+
+            Number numbers[4];
+            int count = 0;
+            for (;;) {
+                scanner.SkipSpaces();
+                if (count == 4)
+                    return fail(result, ColorParseError::TooManyComponents, scanner.Pos());
+                if (!parseNumber(scanner, numbers[count], result))
+                    return false;
+                ++count;
+
+                scanner.SkipSpaces();
+                if (scanner.Accept(','))
+                    continue;
+                if (scanner.Peek() == ')')
+                    break;
+                return fail(result, ColorParseError::UnexpectedCharacter, scanner.Pos());
+            }
+
+            if (count < 3)
+                return fail(result, ColorParseError::MissingComponent, scanner.Pos());
+            scanner.Advance();
+
+            double alpha = 1.0;
+            if (count == 4 && !alphaComponent(numbers[3], alpha, result))
+                return false;
+
+            double c[3] = { 0, 0, 0 };
+            switch (function) {
+            case ColorFunction::Rgb:
+                for (int i = 0; i < 3; ++i) {
+                    if (!unitComponent(numbers[i], 255.0, c[i], result))
+                        return false;
+                }
+                result.color = QColor::fromRgbF(c[0], c[1], c[2], alpha);
+                break;
+            case ColorFunction::Hsv:
+                if (!hueComponent(numbers[0], c[0], result)
+                    || !unitComponent(numbers[1], 255.0, c[1], result)
+                    || !unitComponent(numbers[2], 255.0, c[2], result))
+                    return false;
+                result.color = QColor::fromHsvF(c[0] / 360.0, c[1], c[2], alpha);
+                break;
+            case ColorFunction::Hsl:
+                if (!hueComponent(numbers[0], c[0], result)
+                    || !unitComponent(numbers[1], 100.0, c[1], result)
+                    || !unitComponent(numbers[2], 100.0, c[2], result))
+                    return false;
+                result.color = QColor::fromHslF(c[0] / 360.0, c[1], c[2], alpha);
+                break;
+            }
+
+            return true;
+        }
+
+        bool parseName(QStringView name, int name_pos, ColorParseResult &result)
+        {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 4, 0)
+            const QColor color = QColor::fromString(name);
+#else
+            QColor color;
+            color.setNamedColor(name);
+#endif
+            if (!color.isValid())
+                return fail(result, ColorParseError::UnknownName, name_pos);
+
+            result.color = color;
+            return true;
+        }
+    }
+
+    ColorParseResult ParseColor(QStringView text, HexAlphaOrder hex_alpha)
+    {
+        ColorParseResult result;
+        Scanner scanner(text);
+
+        scanner.SkipSpaces();
+        if (scanner.AtEnd()) {
+            fail(result, ColorParseError::Empty, scanner.Pos());
+            return result;
+        }
+
+        bool ok = false;
+        if (scanner.Peek() == '#') {
+            ok = parseHex(scanner, hex_alpha, result);
+        }
+        else if (isLetter(scanner.Peek())) {
+            const int name_pos = scanner.Pos();
+            while (isLetter(scanner.Peek()))
+                scanner.Advance();
+            const QStringView name = scanner.Slice(name_pos);
+
+            scanner.SkipSpaces();
+            if (scanner.Peek() == '(')
+                ok = parseFunction(scanner, name, name_pos, result);
+            else
+                ok = parseName(name, name_pos, result);
+        }
+        else {
+            fail(result, ColorParseError::UnexpectedCharacter, scanner.Pos());
+        }
+
+        if (ok) {
+            scanner.SkipSpaces();
+            if (!scanner.AtEnd())
+                fail(result, ColorParseError::TrailingCharacters, scanner.Pos());
+        }
+
+        if (!result.IsValid())
+            result.color = QColor();
+
+        return result;
+    }
+}
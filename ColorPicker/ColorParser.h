@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QColor>
+#include <QStringView>
+
+namespace Custom_Control
+{
+    enum class ColorParseError
+    {
+        None,
+        Empty,                  // 空串或只有空白
+        UnexpectedCharacter,    // 出现不属于语法的字符
+        InvalidHexLength,       // #后不是3/4/6/8位十六进制
+        InvalidNumber,          // 需要数字的位置没有数字
+        OutOfRange,             // 分量超出取值范围
+        MissingComponent,       // 分量个数不足
+        TooManyComponents,      // 分量个数过多
+        UnknownFunction,        // 不支持的函数名
+        UnknownName,            // 未知的颜色名
+        TrailingCharacters      // 颜色之后还有多余字符
+    };
+
+    // 4位与8位十六进制中透明度的位置
+    enum class HexAlphaOrder
+    {
+        Last,   // CSS：#rgba、#rrggbbaa
+        First   // Qt：#argb、#aarrggbb，与QColor(QString)及QColor::name(QColor::HexArgb)一致
+    };
+
+    struct ColorParseResult
+    {
+        QColor color;
+        ColorParseError error = ColorParseError::None;
+        int error_pos = -1;     // 出错字符在输入中的下标
+
+        bool IsValid() const { return error == ColorParseError::None; }
+    };
+
+    // 单遍解析CSS颜色字符串，不分配内存
+    // 支持：#rgb #rgba #rrggbb #rrggbbaa（默认透明度在末尾，见hex_alpha）
+    //      rgb()/rgba()：分量为0~255或百分比
+    //      hsv()/hsva()：色相为角度，饱和度与明度为0~255或百分比
+    //      hsl()/hsla()：色相为角度，饱和度与亮度为百分比（省略%时按0~100）
+    //      透明度为0~1或百分比，兼容旧格式的0~255整数
+    //      SVG颜色名，如red、transparent
+    // 兼容性：旧的colorFromStr经由QColor读取8位十六进制，透明度在最前(#AARRGGBB)；
+    // 默认按CSS把末尾两位当作透明度，#80FF0000会被读成另一种颜色。
+    // 导入由QColor::name(QColor::HexArgb)或旧版本保存的主题字符串时须传HexAlphaOrder::First
+    ColorParseResult ParseColor(QStringView text, HexAlphaOrder hex_alpha = HexAlphaOrder::Last);
+}
@@ -0,0 +1,277 @@
+#include "ColorPlane.h"
+#include "ColorSpace.h"
+#include <QVarLengthArray>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLOR_PLANE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(COLOR_PLANE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define COLOR_PLANE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define COLOR_PLANE_TARGET_AVX2
+#endif
+
+namespace Custom_Control
+{
+    namespace
+    {
+        // 每行的通道值 = 列系数 * 明度，系数在行间共享
+        struct PlaneRow
+        {
+            const float *k_red;
+            const float *k_green;
+            const float *k_blue;
+            int width;
+        };
+
+        using RowKernel = void (*)(const PlaneRow &row, float scale, quint32 *dst);
+
+        // 与QColor::toRgb一致：16位四舍五入后取高8位
+        inline quint32 channel(float k, float scale)
+        {
+            return quint32(k * scale + 0.5f) >> 8;
+        }
+
+        void fillRowScalar(const PlaneRow &row, float scale, quint32 *dst)
+        {
+            for (int x = 0; x < row.width; ++x) {
+                dst[x] = 0xFF000000u
+                    | (channel(row.k_red[x], scale) << 16)
+                    | (channel(row.k_green[x], scale) << 8)
+                    | channel(row.k_blue[x], scale);
+            }
+        }
+
+#ifdef COLOR_PLANE_X86
+        void fillRowSSE2(const PlaneRow &row, float scale, quint32 *dst)
+        {
+            const __m128 v_scale = _mm_set1_ps(scale);
+            const __m128 v_half = _mm_set1_ps(0.5f);
+            const __m128i v_alpha = _mm_set1_epi32(int(0xFF000000u));
+
+            int x = 0;
+            for (; x + 4 <= row.width; x += 4) {
+                const __m128i r = _mm_srli_epi32(_mm_cvttps_epi32(
+                    _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(row.k_red + x), v_scale), v_half)), 8);
+                const __m128i g = _mm_srli_epi32(_mm_cvttps_epi32(
+                    _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(row.k_green + x), v_scale), v_half)), 8);
+                const __m128i b = _mm_srli_epi32(_mm_cvttps_epi32(
+                    _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(row.k_blue + x), v_scale), v_half)), 8);
+
+                const __m128i argb = _mm_or_si128(_mm_or_si128(v_alpha, _mm_slli_epi32(r, 16)),
+                    _mm_or_si128(_mm_slli_epi32(g, 8), b));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), argb);
+            }
+
+            for (; x < row.width; ++x) {
+                dst[x] = 0xFF000000u
+                    | (channel(row.k_red[x], scale) << 16)
+                    | (channel(row.k_green[x], scale) << 8)
+                    | channel(row.k_blue[x], scale);
+            }
+        }
+
+        COLOR_PLANE_TARGET_AVX2
+        void fillRowAVX2(const PlaneRow &row, float scale, quint32 *dst)
+        {
+            const __m256 v_scale = _mm256_set1_ps(scale);
+            const __m256 v_half = _mm256_set1_ps(0.5f);
+            const __m256i v_alpha = _mm256_set1_epi32(int(0xFF000000u));
+
+            int x = 0;
+            for (; x + 8 <= row.width; x += 8) {
+                const __m256i r = _mm256_srli_epi32(_mm256_cvttps_epi32(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(row.k_red + x), v_scale), v_half)), 8);
+                const __m256i g = _mm256_srli_epi32(_mm256_cvttps_epi32(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(row.k_green + x), v_scale), v_half)), 8);
+                const __m256i b = _mm256_srli_epi32(_mm256_cvttps_epi32(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(row.k_blue + x), v_scale), v_half)), 8);
+
+                const __m256i argb = _mm256_or_si256(_mm256_or_si256(v_alpha, _mm256_slli_epi32(r, 16)),
+                    _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), argb);
+            }
+
+            for (; x < row.width; ++x) {
+                dst[x] = 0xFF000000u
+                    | (channel(row.k_red[x], scale) << 16)
+                    | (channel(row.k_green[x], scale) << 8)
+                    | channel(row.k_blue[x], scale);
+            }
+        }
+
+        bool cpuHasAVX2()
+        {
+#if defined(_MSC_VER)
+            int info[4] = { 0 };
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+
+            // AVX需要操作系统保存YMM寄存器
+            __cpuid(info, 1);
+            const bool os_xsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            if (!os_xsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+                return false;
+
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        PlaneKernel detectKernel()
+        {
+#ifdef COLOR_PLANE_X86
+            return cpuHasAVX2() ? PlaneKernel::AVX2 : PlaneKernel::SSE2;
+#else
+            return PlaneKernel::Scalar;
+#endif
+        }
+
+        RowKernel rowKernel(PlaneKernel kernel)
+        {
+            switch (kernel) {
+#ifdef COLOR_PLANE_X86
+            case PlaneKernel::AVX2:
+                return fillRowAVX2;
+            case PlaneKernel::SSE2:
+                return fillRowSSE2;
+#endif
+            default:
+                return fillRowScalar;
+            }
+        }
+    }
+
+    PlaneKernel ActivePlaneKernel()
+    {
+        static const PlaneKernel kernel = detectKernel();
+        return kernel;
+    }
+
+    bool IsPlaneKernelSupported(PlaneKernel kernel)
+    {
+        switch (kernel) {
+#ifdef COLOR_PLANE_X86
+        case PlaneKernel::AVX2:
+            return ActivePlaneKernel() == PlaneKernel::AVX2;
+        case PlaneKernel::SSE2:
+            return true;
+#endif
+        case PlaneKernel::Scalar:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool FillSVPlane(QImage &image, int hue)
+    {
+        return FillSVPlane(image, hue, ActivePlaneKernel());
+    }
+
+    bool FillSVPlane(QImage &image, int hue, PlaneKernel kernel)
+    {
+        if (!IsPlaneKernelSupported(kernel))
+            return false;
+
+        if (image.isNull() || image.format() != QImage::Format_ARGB32_Premultiplied)
+            return false;
+
+        if (hue < 0 || hue > 359)
+            return false;
+
+        const int width = image.width();
+        const int height = image.height();
+
+        // 色相区间i及区间内偏移f决定每个通道的系数：c = v * (1 - s * k)
+        // k取值为0(v)、1(p)、f(q)、1-f(t)，与QColor::toRgb的分支对应
+        const double h = hue / 60.0;
+        const int sector = int(h);
+        const double f = h - sector;
+        static const int k_table[6][3] = {
+            { 0, 3, 1 },    // v t p
+            { 2, 0, 1 },    // q v p
+            { 1, 0, 3 },    // p v t
+            { 1, 2, 0 },    // p q v
+            { 3, 1, 0 },    // t p v
+            { 0, 1, 2 }     // v p q
+        };
+        const double k_values[4] = { 0.0, 1.0, f, 1.0 - f };
+        const double k_red = k_values[k_table[sector][0]];
+        const double k_green = k_values[k_table[sector][1]];
+        const double k_blue = k_values[k_table[sector][2]];
+
+        QVarLengthArray<float, 1024> coefficients(width * 3);
+        float *red = coefficients.data();
+        float *green = red + width;
+        float *blue = green + width;
+        for (int x = 0; x < width; ++x) {
+            const double s = (x * 255 / width) / 255.0;
+            red[x] = float(1.0 - s * k_red);
+            green[x] = float(1.0 - s * k_green);
+            blue[x] = float(1.0 - s * k_blue);
+        }
+
+        const PlaneRow row { red, green, blue, width };
+        const RowKernel row_kernel = rowKernel(kernel);
+        for (int y = 0; y < height; ++y) {
+            const int value = 255 - y * 255 / height;
+            row_kernel(row, float(value * 257), reinterpret_cast<quint32 *>(image.scanLine(y)));
+        }
+
+        return true;
+    }
+
+    bool FillOkLchPlane(QImage &image, int hue, float max_chroma)
+    {
+        if (image.isNull() || image.format() != QImage::Format_ARGB32_Premultiplied)
+            return false;
+
+        if (hue < 0 || hue > 359 || max_chroma <= 0)
+            return false;
+
+        const int width = image.width();
+        const int height = image.height();
+
+        QVarLengthArray<ColorTriple, 1024> lch(width);
+        QVarLengthArray<bool, 1024> out_of_gamut(width);
+        for (int x = 0; x < width; ++x)
+            lch[x] = { 0.0f, (x * 255 / width) / 255.0f * max_chroma, float(hue) };
+
+        for (int y = 0; y < height; ++y) {
+            const float lightness = (255 - y * 255 / height) / 255.0f;
+            for (int x = 0; x < width; ++x)
+                lch[x].c0 = lightness;
+
+            QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+            ConvertToRgb(ColorSpaceId::OkLch, lch.constData(), line, width, out_of_gamut.data());
+
+            // 同一亮度与色相下色域内的色度是一段连续区间，边界颜色每行只求一次
+            bool has_edge = false;
+            QRgb edge = 0;
+            for (int x = 0; x < width; ++x) {
+                if (!out_of_gamut[x])
+                    continue;
+
+                if (!has_edge) {
+                    edge = OkLchToRgbInGamut(lightness, max_chroma, float(hue));
+                    has_edge = true;
+                }
+                line[x] = edge;
+            }
+        }
+
+        return true;
+    }
+}
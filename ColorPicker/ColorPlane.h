@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QImage>
+
+namespace Custom_Control
+{
+    // SV平面像素生成所使用的指令集，运行时按CPU能力选择
+    enum class PlaneKernel
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    PlaneKernel ActivePlaneKernel();
+
+    // 当前CPU能否运行指定的指令集
+    bool IsPlaneKernelSupported(PlaneKernel kernel);
+
+    // 以固定色相填充SV平面：x方向为饱和度(0→255)，y方向为明度(255→0)
+    // 像素映射与ColorSVCanvas::valueFromPos一致，颜色与QColor::setHsv误差不超过1
+    // image须为QImage::Format_ARGB32_Premultiplied
+    bool FillSVPlane(QImage &image, int hue);
+
+    // 指定指令集填充，供基准测试比较各实现；CPU不支持该指令集时返回false
+    bool FillSVPlane(QImage &image, int hue, PlaneKernel kernel);
+
+    // 以固定OKLCH色相填充平面：x方向为色度(0→max_chroma)，y方向为亮度(1→0)
+    // 像素按ColorSVCanvas::valueFromPos量化到0~255后再换算，超出sRGB色域的像素取该行色域边界上的颜色，
+    // 与OkLchToRgbInGamut的拾取结果一致
+    bool FillOkLchPlane(QImage &image, int hue, float max_chroma);
+}
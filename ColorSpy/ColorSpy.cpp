@@ -1,4 +1,6 @@
 #include "ColorSpy.h"
+#include "RecentColorStore.h"
+#include "NamedColorIndex.h"
 #include <QTimer>
 #include <QScreen>
 #include <QApplication>
@@ -8,9 +10,507 @@
 #include <QScreen>
 #endif
 #include <QKeyEvent>
+#include <QMouseEvent>
+#include <QWindow>
+#include <QCursor>
+#include <QPainter>
+#include <cstring>
+#include <algorithm>
 
 namespace Custom_Control
 {
+    namespace
+    {
+        const int kFixedInterval = 20;
+        // Probe once per frame while the cursor moves.
+        const int kActiveInterval = 16;
+        // While still, cursor probes back off to this interval...
+        const int kMaxProbeInterval = 100;
+        // ...and the screen is re-read with exponential backoff up to this interval.
+        const int kMinIdleRefreshInterval = 50;
+        const int kMaxIdleRefreshInterval = 1000;
+        // Extra logical pixels captured around the loupe on every side.
+        const int kLoupeMargin = 16;
+        // Time for the compositor to remove the region overlay before the screen is read.
+        const int kOverlayHideDelay = 100;
+
+        // The captured block has to cover both the loupe and the sample kernel.
+        int captureGrid(const SpySampleRequest &request)
+        {
+            return qMax(request.loupe_grid, request.sample_size);
+        }
+
+        QRect captureRect(const SpySampleRequest &request)
+        {
+            const int extent = captureGrid(request) + kLoupeMargin * 2;
+            return QRect(request.cursor.x() - extent / 2, request.cursor.y() - extent / 2, extent, extent);
+        }
+
+        // Reuse the last capture for small moves. Re-read the screen when the cursor is
+        // still (to pick up on-screen changes) or the loupe would leave the captured area.
+        // Near a screen edge only the on-screen part of the loupe has to be covered.
+        bool needsCapture(const QImage &capture, const QRect &capture_rect, const QPoint &capture_cursor_pos,
+            const SpySampleRequest &request)
+        {
+            const QPoint &cursor = request.cursor;
+            const int grid = captureGrid(request);
+            QRect loupe_rect(cursor.x() - grid / 2, cursor.y() - grid / 2, grid, grid);
+            if (!request.screen.geometry.isEmpty())
+                loupe_rect &= request.screen.geometry;
+
+            const bool moved = cursor != capture_cursor_pos;
+            return capture.isNull() || !moved || !capture_rect.contains(loupe_rect);
+        }
+
+        QPoint globalMousePos(const QMouseEvent *ev)
+        {
+#if QT_VERSION < QT_VERSION_CHECK(6,0,0)
+            return ev->globalPos();
+#else
+            return ev->globalPosition().toPoint();
+#endif
+        }
+
+        // Copies the size x size block centred on center into block, black outside source.
+        // block is reallocated only when the size changes.
+        void copyBlock(const QImage &source, const QPoint &center, int size, QImage &block)
+        {
+            if (block.width() != size || block.height() != size)
+                block = QImage(size, size, QImage::Format_RGB32);
+
+            const int left = center.x() - size / 2;
+            const int top = center.y() - size / 2;
+            const int x0 = qMax(0, left);
+            const int x1 = qMin(source.width(), left + size);
+            for (int y = 0; y < size; ++y) {
+                QRgb *dst = reinterpret_cast<QRgb *>(block.scanLine(y));
+                const int sy = top + y;
+                if (sy < 0 || sy >= source.height() || x0 >= x1) {
+                    std::fill_n(dst, size, 0xFF000000u);
+                    continue;
+                }
+
+                const QRgb *src = reinterpret_cast<const QRgb *>(source.constScanLine(sy));
+                std::fill_n(dst, x0 - left, 0xFF000000u);
+                std::memcpy(dst + (x0 - left), src + x0, size_t(x1 - x0) * sizeof(QRgb));
+                std::fill_n(dst + (x1 - left), left + size - x1, 0xFF000000u);
+            }
+        }
+
+        const char kHexDigits[] = "0123456789ABCDEF";
+
+        int appendInt(int value, char *out)
+        {
+            char digits[12];
+            int n = 0;
+            unsigned int magnitude = value < 0 ? 0u - unsigned(value) : unsigned(value);
+            do {
+                digits[n++] = char('0' + magnitude % 10);
+                magnitude /= 10;
+            } while (magnitude);
+
+            int len = 0;
+            if (value < 0)
+                out[len++] = '-';
+
+            while (n)
+                out[len++] = digits[--n];
+
+            return len;
+        }
+
+        int appendLiteral(const char *text, char *out)
+        {
+            int len = 0;
+            while (text[len]) {
+                out[len] = text[len];
+                ++len;
+            }
+            return len;
+        }
+
+        // "#RRGGBB", always seven characters.
+        int formatHex(QRgb rgb, char *out)
+        {
+            out[0] = '#';
+            for (int i = 0; i < 6; ++i)
+                out[1 + i] = kHexDigits[(rgb >> (20 - i * 4)) & 0xF];
+
+            return 7;
+        }
+
+        // "R:r G:g B:b"
+        int formatRgb(QRgb rgb, char *out)
+        {
+            int len = appendLiteral("R:", out);
+            len += appendInt(qRed(rgb), out + len);
+            len += appendLiteral(" G:", out + len);
+            len += appendInt(qGreen(rgb), out + len);
+            len += appendLiteral(" B:", out + len);
+            len += appendInt(qBlue(rgb), out + len);
+            return len;
+        }
+
+        // "x:x y:y"
+        int formatPosition(const QPoint &pos, char *out)
+        {
+            int len = appendLiteral("x:", out);
+            len += appendInt(pos.x(), out + len);
+            len += appendLiteral(" y:", out + len);
+            len += appendInt(pos.y(), out + len);
+            return len;
+        }
+    }
+
+    ColorLoupe::ColorLoupe(QWidget *parent)
+        : QWidget(parent)
+    {
+        resizeBuffer();
+    }
+
+    ColorLoupe::~ColorLoupe()
+    {
+
+    }
+
+    void ColorLoupe::SetGridSize(int size)
+    {
+        size = qMax(1, size | 1);
+        if (size == m_grid_size_)
+            return;
+
+        m_grid_size_ = size;
+        resizeBuffer();
+    }
+
+    int ColorLoupe::GetGridSize() const
+    {
+        return m_grid_size_;
+    }
+
+    void ColorLoupe::SetZoom(int zoom)
+    {
+        zoom = qMax(1, zoom);
+        if (zoom == m_zoom_)
+            return;
+
+        m_zoom_ = zoom;
+        resizeBuffer();
+    }
+
+    int ColorLoupe::GetZoom() const
+    {
+        return m_zoom_;
+    }
+
+    void ColorLoupe::SetSource(const QImage &capture, const QPoint &center)
+    {
+        if (capture.depth() != 32)
+            return;
+
+        // Nearest-neighbour: widen each source pixel into a run, then copy the row zoom-1 times.
+        const int half = m_grid_size_ / 2;
+        const int row_bytes = m_zoomed_.width() * 4;
+        for (int gy = 0; gy < m_grid_size_; ++gy) {
+            const int sy = center.y() - half + gy;
+            const QRgb *src = (sy >= 0 && sy < capture.height())
+                ? reinterpret_cast<const QRgb *>(capture.constScanLine(sy)) : nullptr;
+
+            QRgb *dst = reinterpret_cast<QRgb *>(m_zoomed_.scanLine(gy * m_zoom_));
+            for (int gx = 0; gx < m_grid_size_; ++gx) {
+                const int sx = center.x() - half + gx;
+                const QRgb pixel = (src && sx >= 0 && sx < capture.width()) ? (src[sx] | 0xFF000000u) : 0xFF000000u;
+                std::fill_n(dst + gx * m_zoom_, m_zoom_, pixel);
+            }
+
+            for (int r = 1; r < m_zoom_; ++r)
+                std::memcpy(m_zoomed_.scanLine(gy * m_zoom_ + r), dst, size_t(row_bytes));
+        }
+
+        update();
+    }
+
+    void ColorLoupe::paintEvent(QPaintEvent *)
+    {
+        QPainter painter(this);
+        painter.drawImage(0, 0, m_zoomed_);
+
+        // Crosshair: outline the cursor pixel in black and white so it shows on any colour.
+        const int half = m_grid_size_ / 2;
+        const QRect cell(half * m_zoom_, half * m_zoom_, m_zoom_, m_zoom_);
+        painter.setPen(Qt::black);
+        painter.drawRect(cell.adjusted(-1, -1, 0, 0));
+        painter.setPen(Qt::white);
+        painter.drawRect(cell.adjusted(0, 0, -1, -1));
+
+        const int mid = cell.center().x();
+        painter.drawLine(mid, 0, mid, cell.top() - 2);
+        painter.drawLine(mid, cell.bottom() + 2, mid, height());
+        painter.drawLine(0, mid, cell.left() - 2, mid);
+        painter.drawLine(cell.right() + 2, mid, width(), mid);
+    }
+
+    void ColorLoupe::resizeBuffer()
+    {
+        const int side = m_grid_size_ * m_zoom_;
+        m_zoomed_ = QImage(side, side, QImage::Format_RGB32);
+        m_zoomed_.fill(Qt::black);
+        setFixedSize(side, side);
+        update();
+    }
+
+    RegionSelector::RegionSelector(QWidget *parent)
+        : QWidget(parent, Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint | Qt::Tool)
+    {
+        setAttribute(Qt::WA_TranslucentBackground);
+        setCursor(Qt::CrossCursor);
+        setFocusPolicy(Qt::StrongFocus);
+    }
+
+    RegionSelector::~RegionSelector()
+    {
+
+    }
+
+    void RegionSelector::Start(QScreen *screen)
+    {
+        m_dragging_ = false;
+        m_selection_ = QRect();
+        if (screen)
+            setGeometry(screen->geometry());
+
+        show();
+        raise();
+        activateWindow();
+        setFocus();
+    }
+
+    void RegionSelector::paintEvent(QPaintEvent *)
+    {
+        QPainter painter(this);
+        painter.fillRect(rect(), QColor(0, 0, 0, 64));
+        if (m_selection_.isEmpty())
+            return;
+
+        const QRect selection = m_selection_.translated(-geometry().topLeft());
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(selection, Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        painter.setPen(Qt::white);
+        painter.drawRect(selection.adjusted(0, 0, -1, -1));
+    }
+
+    void RegionSelector::mousePressEvent(QMouseEvent *event)
+    {
+        if (event->button() == Qt::RightButton) {
+            hide();
+            emit sig_canceled();
+            return;
+        }
+
+        if (event->button() != Qt::LeftButton)
+            return;
+
+        m_dragging_ = true;
+        m_origin_ = globalMousePos(event);
+        m_selection_ = QRect(m_origin_, QSize(1, 1));
+        update();
+    }
+
+    void RegionSelector::mouseMoveEvent(QMouseEvent *event)
+    {
+        if (!m_dragging_)
+            return;
+
+        m_selection_ = QRect(m_origin_, globalMousePos(event)).normalized() & geometry();
+        update();
+    }
+
+    void RegionSelector::mouseReleaseEvent(QMouseEvent *event)
+    {
+        if (!m_dragging_ || event->button() != Qt::LeftButton)
+            return;
+
+        m_dragging_ = false;
+        hide();
+        if (m_selection_.isEmpty())
+            emit sig_canceled();
+        else
+            emit sig_selected(m_selection_);
+    }
+
+    void RegionSelector::keyPressEvent(QKeyEvent *event)
+    {
+        if (event->key() != Qt::Key_Escape) {
+            QWidget::keyPressEvent(event);
+            return;
+        }
+
+        m_dragging_ = false;
+        hide();
+        emit sig_canceled();
+    }
+
+    ScreenIndex::ScreenIndex(QObject *parent)
+        : QObject(parent)
+    {
+        connect(qApp, SIGNAL(screenAdded(QScreen*)), this, SLOT(slot_invalidate()));
+        connect(qApp, SIGNAL(screenRemoved(QScreen*)), this, SLOT(slot_invalidate()));
+        connect(qApp, SIGNAL(primaryScreenChanged(QScreen*)), this, SLOT(slot_invalidate()));
+    }
+
+    ScreenIndex::~ScreenIndex()
+    {
+
+    }
+
+    QScreen *ScreenIndex::ScreenAt(const QPoint &pos)
+    {
+        if (!m_valid_)
+            rebuild();
+
+        // The cursor usually stays on one screen, try the last hit first.
+        if (m_last_hit_ >= 0 && m_entries_[m_last_hit_].geometry.contains(pos))
+            return m_entries_[m_last_hit_].screen;
+
+        for (int i = 0; i < m_entries_.size(); ++i) {
+            if (m_entries_[i].geometry.contains(pos)) {
+                m_last_hit_ = i;
+                return m_entries_[i].screen;
+            }
+        }
+
+        return QGuiApplication::primaryScreen();
+    }
+
+    void ScreenIndex::slot_invalidate()
+    {
+        m_valid_ = false;
+        m_last_hit_ = -1;
+        m_entries_.clear();
+    }
+
+    void ScreenIndex::rebuild()
+    {
+        const QList<QScreen *> screens = QGuiApplication::screens();
+        m_entries_.clear();
+        m_entries_.reserve(screens.size());
+        for (QScreen *screen : screens) {
+            m_entries_.append({ screen->geometry(), screen });
+            connect(screen, SIGNAL(geometryChanged(QRect)), this, SLOT(slot_invalidate()), Qt::UniqueConnection);
+        }
+
+        m_last_hit_ = -1;
+        m_valid_ = true;
+    }
+
+    ColorSpyWorker::ColorSpyWorker(QObject *parent)
+        : QObject(parent)
+    {
+
+    }
+
+    ColorSpyWorker::~ColorSpyWorker()
+    {
+
+    }
+
+    void ColorSpyWorker::Request(const SpySampleRequest &request)
+    {
+        m_requests_.Back() = request;
+        m_requests_.Publish();
+
+        if (!m_process_queued_.exchange(true))
+            QMetaObject::invokeMethod(this, [this] { process(); }, Qt::QueuedConnection);
+    }
+
+    const SpySampleResult *ColorSpyWorker::TakeResult()
+    {
+        // Clear first so a result published after Take() posts a new notification.
+        m_result_queued_.store(false);
+        return m_results_.Take();
+    }
+
+    void ColorSpyWorker::SetSampler(std::shared_ptr<ScreenSampler> sampler)
+    {
+        QMetaObject::invokeMethod(this, [this, sampler] {
+            // The capture may be a view into the old sampler's buffer.
+            m_capture_ = QImage();
+            m_sampler_ = sampler;
+        }, Qt::QueuedConnection);
+    }
+
+    void ColorSpyWorker::RequestRegion(const SpyRegionRequest &request)
+    {
+        m_region_requests_.Back() = request;
+        m_region_requests_.Publish();
+        QMetaObject::invokeMethod(this, [this] { processRegion(); }, Qt::QueuedConnection);
+    }
+
+    const SpyRegionResult *ColorSpyWorker::TakeRegion()
+    {
+        return m_region_results_.Take();
+    }
+
+    void ColorSpyWorker::processRegion()
+    {
+        const SpyRegionRequest *request = m_region_requests_.Take();
+        if (!request)
+            return;
+
+        QImage capture = request->capture;
+        if (capture.isNull() && m_sampler_ && m_sampler_->IsThreadSafe()) {
+            capture = m_sampler_->Grab(request->screen, request->rect);
+            // The region grab may have resized the sampler's buffer under the cursor capture.
+            m_capture_ = QImage();
+        }
+
+        SpyRegionResult &result = m_region_results_.Back();
+        result.palette = capture.isNull() ? QVector<PaletteEntry>() : ExtractPalette(capture, request->count);
+        m_region_results_.Publish();
+        emit sig_regionReady();
+    }
+
+    void ColorSpyWorker::process()
+    {
+        m_process_queued_.store(false);
+        while (const SpySampleRequest *request = m_requests_.Take())
+            sample(*request);
+    }
+
+    void ColorSpyWorker::sample(const SpySampleRequest &request)
+    {
+        const QPoint &cursor = request.cursor;
+
+        if (!request.capture.isNull()) {
+            m_capture_ = request.capture;
+            m_capture_rect_ = request.capture_rect;
+        } else if (m_sampler_ && m_sampler_->IsThreadSafe()) {
+            if (needsCapture(m_capture_, m_capture_rect_, m_capture_cursor_pos_, request))
+                m_capture_ = m_sampler_->Grab(request.screen, captureRect(request), &m_capture_rect_);
+        } else {
+            // A GUI-thread sampler without a capture, e.g. a request queued before a sampler swap.
+            m_capture_ = QImage();
+        }
+        m_capture_cursor_pos_ = cursor;
+
+        if (m_capture_.isNull())
+            return;
+
+        const QPoint pixel_pos = (cursor - m_capture_rect_.topLeft()) * m_capture_.devicePixelRatio();
+        if (!m_capture_.rect().contains(pixel_pos))
+            return;
+
+        SpySampleResult &result = m_results_.Back();
+        result.cursor = cursor;
+        result.rgb = ReduceSampleBlock(m_capture_, pixel_pos, request.sample_size, request.reduction);
+        copyBlock(m_capture_, pixel_pos, request.loupe_grid, result.loupe);
+
+        m_results_.Publish();
+        if (!m_result_queued_.exchange(true))
+            emit sig_resultReady();
+    }
+
     ColorSpy::ColorSpy(QWidget *parent)
         :QWidget(parent)
     {
@@ -23,6 +523,15 @@ namespace Custom_Control
         uinit_connection();
         if (m_timer_)
             m_timer_->deleteLater();
+
+        delete m_region_selector_;
+
+        // Waits for a capture in flight, the worker is deleted once its thread is gone.
+        if (m_worker_thread_) {
+            m_worker_thread_->quit();
+            m_worker_thread_->wait();
+        }
+        delete m_worker_;
     }
 
     QColor ColorSpy::GetColor()
@@ -32,8 +541,14 @@ namespace Custom_Control
 
     void ColorSpy::StartTimer()
     {
+        m_last_cursor_pos_ = QPoint(-1, -1);
+        m_idle_refresh_interval_ = kMinIdleRefreshInterval;
+        m_idle_clock_.start();
+        m_rate_clock_.start();
+        m_rate_sample_count_ = 0;
+
         if (m_timer_)
-            m_timer_->start(20);
+            m_timer_->start(m_sampling_policy_ == FixedRate ? kFixedInterval : kActiveInterval);
 
         installEventFilter(this);
 
@@ -44,11 +559,84 @@ namespace Custom_Control
         if (m_timer_)
             m_timer_->stop();
 
+        m_samples_per_second_ = 0;
         removeEventFilter(this);
     }
 
+    void ColorSpy::SetSamplingPolicy(SamplingPolicy policy)
+    {
+        if (m_sampling_policy_ == policy)
+            return;
+
+        m_sampling_policy_ = policy;
+        if (m_timer_ && m_timer_->isActive())
+            StartTimer();
+    }
+
+    ColorSpy::SamplingPolicy ColorSpy::GetSamplingPolicy() const
+    {
+        return m_sampling_policy_;
+    }
+
+    qreal ColorSpy::GetSamplesPerSecond() const
+    {
+        return m_samples_per_second_;
+    }
+
+    void ColorSpy::SetSampler(std::unique_ptr<ScreenSampler> sampler)
+    {
+        m_sampler_ = sampler ? std::shared_ptr<ScreenSampler>(std::move(sampler))
+            : std::shared_ptr<ScreenSampler>(CreateScreenSampler());
+        m_capture_ = QImage();
+
+        if (m_worker_)
+            m_worker_->SetSampler(m_sampler_);
+    }
+
+    const ScreenSampler *ColorSpy::Sampler() const
+    {
+        return m_sampler_.get();
+    }
+
+    void ColorSpy::SetSampleSize(int size)
+    {
+        if (IsValidSampleSize(size))
+            m_sample_size_ = size;
+    }
+
+    int ColorSpy::GetSampleSize() const
+    {
+        return m_sample_size_;
+    }
+
+    void ColorSpy::SetSampleReduction(SampleReduction reduction)
+    {
+        m_sample_reduction_ = reduction;
+    }
+
+    SampleReduction ColorSpy::GetSampleReduction() const
+    {
+        return m_sample_reduction_;
+    }
+
     void ColorSpy::init()
     {
+        m_sampler_ = CreateScreenSampler();
+        if (!m_screen_index_)
+            m_screen_index_ = new (std::nothrow) ScreenIndex(this);
+
+        if (!m_worker_thread_) {
+            m_worker_thread_ = new (std::nothrow) QThread(this);
+            m_worker_thread_->setObjectName("color_spy_worker");
+        }
+
+        if (!m_worker_) {
+            m_worker_ = new (std::nothrow) ColorSpyWorker();
+            m_worker_->moveToThread(m_worker_thread_);
+            m_worker_->SetSampler(m_sampler_);
+            m_worker_thread_->start();
+        }
+
         initUI();
         init_connection();
     }
@@ -66,6 +654,12 @@ namespace Custom_Control
         m_show_lab_.setMinimumSize(QSize(100, 100));
         m_show_lab_.setMaximumSize(QSize(500, 500));
         m_show_lab_.setStyleSheet("border:1px solid rgb(0,0,0)");
+        m_show_lab_.installEventFilter(this);
+
+        if (!m_loupe_)
+            m_loupe_ = new (std::nothrow) ColorLoupe();
+
+        m_hlayout_->addWidget(m_loupe_);
 
         if (!m_grid_layout_)
             m_grid_layout_ = new (std::nothrow)QGridLayout();
@@ -79,6 +673,9 @@ namespace Custom_Control
         if (!m_position_edit_)
             m_position_edit_ = new (std::nothrow) QLineEdit();
 
+        if (!m_name_edit_)
+            m_name_edit_ = new (std::nothrow) QLineEdit();
+
         m_grid_layout_->addWidget(&m_hex_lab_, 0, 0);
         m_grid_layout_->addWidget(m_hex_edit_, 1, 0);
 
@@ -88,6 +685,9 @@ namespace Custom_Control
         m_grid_layout_->addWidget(&m_position_lab_, 0, 2);
         m_grid_layout_->addWidget(m_position_edit_, 1, 2);
 
+        m_grid_layout_->addWidget(&m_name_lab_, 0, 3);
+        m_grid_layout_->addWidget(m_name_edit_, 1, 3);
+
         m_hlayout_->addLayout(m_grid_layout_);
 
         this->setLayout(m_hlayout_);
@@ -97,7 +697,19 @@ namespace Custom_Control
     {
         if (!m_timer_) {
             m_timer_ = new (std::nothrow) QTimer(this);
-            connect(m_timer_, SIGNAL(timeout()), this, SLOT(slot_showColorValue()));
+            connect(m_timer_, SIGNAL(timeout()), this, SLOT(slot_pollCursor()));
+        }
+
+        if (!m_frame_timer_) {
+            m_frame_timer_ = new (std::nothrow) QTimer(this);
+            m_frame_timer_->setSingleShot(true);
+            m_frame_timer_->setTimerType(Qt::PreciseTimer);
+            connect(m_frame_timer_, SIGNAL(timeout()), this, SLOT(slot_showColorValue()));
+        }
+
+        if (m_worker_) {
+            connect(m_worker_, SIGNAL(sig_resultReady()), this, SLOT(slot_resultReady()), Qt::QueuedConnection);
+            connect(m_worker_, SIGNAL(sig_regionReady()), this, SLOT(slot_regionReady()), Qt::QueuedConnection);
         }
     }
 
@@ -105,19 +717,50 @@ namespace Custom_Control
     {
         if (m_timer_)
             m_timer_->disconnect();
+
+        if (m_frame_timer_)
+            m_frame_timer_->disconnect();
+
+        if (m_worker_)
+            m_worker_->disconnect(this);
     }
 
     bool ColorSpy::eventFilter(QObject *watched, QEvent *event)
     {
+        if (watched == &m_show_lab_) {
+            if (event->type() != QEvent::Paint)
+                return false;
+
+            QPainter painter(&m_show_lab_);
+            painter.fillRect(m_show_lab_.rect(), m_color_);
+            painter.setPen(Qt::black);
+            painter.drawRect(m_show_lab_.rect().adjusted(0, 0, -1, -1));
+            return true;
+        }
+
+        // Resume sampling once the covered window becomes visible again.
+        QWindow *window = windowHandle();
+        if (window && watched == window) {
+            if (event->type() == QEvent::Expose && window->isExposed() && isVisible()
+                && m_timer_ && !m_timer_->isActive())
+                StartTimer();
+
+            return false;
+        }
+
         if (event->type() == QEvent::KeyPress) {
             const auto key = static_cast<QKeyEvent *>(event);
             if (key && key->key() == Qt::Key_Escape)
                 this->close();
+
+            if (key && key->key() == Qt::Key_R)
+                StartRegionPick(m_region_colors_);
         }
 
         if (event->type() == QEvent::MouseButtonPress) {
             const auto mouse_key_ev = static_cast<QMouseEvent *>(event);
             if (mouse_key_ev && mouse_key_ev->button() == Qt::LeftButton) {
+                RecentColorStore::Instance()->Append(GetColor());
                 emit sig_pickerColor(GetColor());
                 this->close();
             }
@@ -133,6 +776,10 @@ namespace Custom_Control
     void ColorSpy::showEvent(QShowEvent *event)
     {
         QWidget::showEvent(event);
+
+        if (windowHandle())
+            windowHandle()->installEventFilter(this);
+
         StartTimer();
     }
 
@@ -142,51 +789,238 @@ namespace Custom_Control
         StopTimer();
     }
 
-    void ColorSpy::slot_showColorValue()
+    void ColorSpy::slot_pollCursor()
+    {
+        // Nothing to show while the spy itself is covered, wait for the next expose.
+        const QWindow *window = windowHandle();
+        if (window && !window->isExposed()) {
+            m_timer_->stop();
+            m_samples_per_second_ = 0;
+            return;
+        }
+
+        if (m_sampling_policy_ == FixedRate) {
+            requestSample();
+            return;
+        }
+
+        const QPoint pos = QCursor::pos();
+        if (pos != m_last_cursor_pos_) {
+            m_last_cursor_pos_ = pos;
+            m_idle_refresh_interval_ = kMinIdleRefreshInterval;
+            m_timer_->setInterval(kActiveInterval);
+            requestSample();
+            return;
+        }
+
+        // Still cursor: probe less often, but keep refreshing so on-screen changes show up.
+        m_timer_->setInterval(qMin(m_timer_->interval() * 2, kMaxProbeInterval));
+        if (m_idle_clock_.elapsed() >= m_idle_refresh_interval_) {
+            m_idle_refresh_interval_ = qMin(m_idle_refresh_interval_ * 2, kMaxIdleRefreshInterval);
+            requestSample();
+        }
+    }
+
+    void ColorSpy::recordSample()
+    {
+        m_idle_clock_.restart();
+
+        ++m_rate_sample_count_;
+        const qint64 elapsed = m_rate_clock_.elapsed();
+        if (elapsed >= 1000) {
+            m_samples_per_second_ = m_rate_sample_count_ * 1000.0 / elapsed;
+            m_rate_sample_count_ = 0;
+            m_rate_clock_.restart();
+        }
+    }
+
+    void ColorSpy::requestSample()
     {
-        // get mouse position
-        const int x = QCursor::pos().x();
-        const int y = QCursor::pos().y();
+        recordSample();
+        if (!m_worker_)
+            return;
+
+        SpySampleRequest request;
+        request.cursor = QCursor::pos();
+        request.screen = ScreenTarget::FromScreen(m_screen_index_ ? m_screen_index_->ScreenAt(request.cursor)
+            : QApplication::primaryScreen());
+        request.loupe_grid = m_loupe_ ? m_loupe_->GetGridSize() : 1;
+        request.sample_size = m_sample_size_;
+        request.reduction = m_sample_reduction_;
 
-        if (m_position_edit_) {
-            m_position_edit_->setText(tr("x:%1 y:%2").arg(x).arg(y));
+        // QScreen-based samplers must not run on the worker; capture here and let the
+        // worker do only the reduction and loupe copy. Only platforms without a thread-safe
+        // backend (macOS, Wayland, ...) take this path, and there a stalled grab still
+        // blocks the GUI thread.
+        if (m_sampler_ && !m_sampler_->IsThreadSafe()) {
+            if (needsCapture(m_capture_, m_capture_rect_, m_capture_cursor_pos_, request))
+                m_capture_ = m_sampler_->Grab(request.screen, captureRect(request), &m_capture_rect_);
+            m_capture_cursor_pos_ = request.cursor;
+            request.capture = m_capture_;
+            request.capture_rect = m_capture_rect_;
         }
+        m_worker_->Request(request);
+    }
+
+    int ColorSpy::frameInterval() const
+    {
+        const QWindow *window = windowHandle();
+        const QScreen *screen = window ? window->screen() : QGuiApplication::primaryScreen();
+        const qreal refresh_rate = screen ? screen->refreshRate() : 60.0;
 
-        QScreen *screen = QApplication::primaryScreen();
-        QPixmap pixmap = !screen ? QPixmap() : screen->grabWindow(0, x, y, 2, 2);
+        return qMax(1, qRound(1000.0 / (refresh_rate > 0 ? refresh_rate : 60.0)));
+    }
 
-        int red, green, blue;
-        if (pixmap.isNull())
+    void ColorSpy::slot_resultReady()
+    {
+        if (m_frame_timer_ && m_frame_timer_->isActive())
             return;
 
-        QImage image = pixmap.toImage();
+        const int interval = frameInterval();
+        const qint64 elapsed = m_frame_clock_.isValid() ? m_frame_clock_.elapsed() : interval;
+        if (elapsed >= interval || !m_frame_timer_)
+            slot_showColorValue();
+        else
+            m_frame_timer_->start(int(interval - elapsed));
+    }
 
-        if (image.isNull())
+    void ColorSpy::slot_showColorValue()
+    {
+        const SpySampleResult *result = m_worker_ ? m_worker_->TakeResult() : nullptr;
+        if (!result)
             return;
 
-        QColor color = image.pixel(0, 0);
-        red = color.red();
-        green = color.green();
-        blue = color.blue();
+        m_frame_clock_.start();
 
-        const QString hRed = QString::number(red, 16).toUpper();
-        const QString hGreen = QString::number(green, 16).toUpper();
-        const QString hBlue = QString::number(blue, 16).toUpper();
+        const QPoint cursor = result->cursor;
+        const QRgb rgb = result->rgb;
+        if (m_loupe_) {
+            const int half = result->loupe.width() / 2;
+            m_loupe_->SetSource(result->loupe, QPoint(half, half));
+        }
 
-        if (m_hex_edit_ && m_rgb_edit_) {
-            m_hex_edit_->setText(tr("#%1%2%3").arg(hRed).arg(hGreen).arg(hBlue));
-            m_rgb_edit_->setText(tr("R:%1 G:%2 B:%3").arg(red).arg(green).arg(blue));
+        const bool color_changed = !m_has_shown_ || rgb != m_shown_rgb_;
+        const bool pos_changed = !m_has_shown_ || cursor != m_shown_pos_;
+        if (!color_changed && !pos_changed) {
+            ++m_skipped_ui_updates_;
+            return;
         }
 
-        const int width = m_show_lab_.width();
-        const int height = m_show_lab_.height();
-        QPixmap labelPix(width, height);
-        labelPix.fill(color);
-        m_color_ = color;
-        m_show_lab_.setPixmap(labelPix);
+        ++m_ui_updates_;
+        m_has_shown_ = true;
+
+        if (pos_changed) {
+            m_shown_pos_ = cursor;
+            if (m_position_edit_)
+                m_position_edit_->setText(QLatin1String(m_text_buffer_, formatPosition(cursor, m_text_buffer_)));
+        }
+
+        if (!color_changed)
+            return;
+
+        m_shown_rgb_ = rgb;
+        m_color_ = QColor::fromRgb(rgb);
+
+        if (m_hex_edit_)
+            m_hex_edit_->setText(QLatin1String(m_text_buffer_, formatHex(rgb, m_text_buffer_)));
+
+        if (m_rgb_edit_)
+            m_rgb_edit_->setText(QLatin1String(m_text_buffer_, formatRgb(rgb, m_text_buffer_)));
+
+        // Nearest named colour, prefixed with '~' when it is not an exact match.
+        if (m_name_edit_) {
+            const NamedColor *named = NamedColorIndex::Shared().Nearest(rgb);
+            if (!named)
+                m_name_edit_->clear();
+            else if ((named->rgb & RGB_MASK) == (rgb & RGB_MASK))
+                m_name_edit_->setText(named->name);
+            else
+                m_name_edit_->setText(QStringLiteral("~") + named->name);
+        }
+
+        // The swatch paints m_color_ itself, see eventFilter.
+        m_show_lab_.update();
 
         emit sig_timerPickerColor(m_color_);
     }
 
+    void ColorSpy::StartRegionPick(int count)
+    {
+        m_region_colors_ = qMax(1, count);
+        if (!m_region_selector_) {
+            m_region_selector_ = new (std::nothrow) RegionSelector();
+            if (!m_region_selector_)
+                return;
+
+            connect(m_region_selector_, SIGNAL(sig_selected(QRect)), this, SLOT(slot_regionSelected(QRect)));
+            connect(m_region_selector_, SIGNAL(sig_canceled()), this, SLOT(slot_regionCanceled()));
+        }
+
+        // No point sampling the overlay.
+        if (m_timer_)
+            m_timer_->stop();
+
+        const QPoint cursor = QCursor::pos();
+        m_region_selector_->Start(m_screen_index_ ? m_screen_index_->ScreenAt(cursor) : QApplication::primaryScreen());
+    }
+
+    void ColorSpy::slot_regionSelected(const QRect &rect)
+    {
+        // Give the compositor time to drop the overlay, then read the region once.
+        QTimer::singleShot(kOverlayHideDelay, this, [this, rect] {
+            if (!m_worker_) {
+                slot_regionCanceled();
+                return;
+            }
+
+            QScreen *screen = m_screen_index_ ? m_screen_index_->ScreenAt(rect.center()) : QApplication::primaryScreen();
+            SpyRegionRequest request;
+            request.screen = ScreenTarget::FromScreen(screen);
+            request.rect = rect;
+            request.count = m_region_colors_;
+
+            // As with cursor samples, QScreen-based samplers capture here; the histogram and
+            // k-means always run on the worker.
+            if (m_sampler_ && !m_sampler_->IsThreadSafe())
+                request.capture = m_sampler_->Grab(request.screen, rect);
+            m_worker_->RequestRegion(request);
+        });
+    }
+
+    void ColorSpy::slot_regionReady()
+    {
+        const SpyRegionResult *result = m_worker_ ? m_worker_->TakeRegion() : nullptr;
+        if (!result)
+            return;
+
+        QVector<QColor> colors;
+        QVector<qreal> weights;
+        colors.reserve(result->palette.size());
+        weights.reserve(result->palette.size());
+        for (const PaletteEntry &entry : result->palette) {
+            colors.append(QColor::fromRgb(entry.rgb));
+            weights.append(entry.weight);
+        }
+
+        emit sig_regionPalette(colors, weights);
+        slot_regionCanceled();
+    }
+
+    void ColorSpy::slot_regionCanceled()
+    {
+        if (isVisible())
+            StartTimer();
+    }
+
+    qint64 ColorSpy::GetUiUpdateCount() const
+    {
+        return m_ui_updates_;
+    }
+
+    qint64 ColorSpy::GetSkippedUiUpdateCount() const
+    {
+        return m_skipped_ui_updates_;
+    }
+
 
 }
@@ -5,12 +5,206 @@
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QThread>
+#include <atomic>
+#include <memory>
+
+#include "ScreenSampler.h"
+#include "SampleReducer.h"
+#include "LatestValue.h"
+#include "PaletteExtractor.h"
 
 namespace Custom_Control
 {
+    // Magnifies a square block of captured screen pixels with nearest-neighbour zoom.
+    class ColorLoupe : public QWidget
+    {
+        Q_OBJECT
+    public:
+        explicit ColorLoupe(QWidget *parent = nullptr);
+        ~ColorLoupe() override;
+
+        // Source pixels per side, forced to an odd number so the cursor pixel is centred.
+        void SetGridSize(int size);
+        int GetGridSize() const;
+
+        void SetZoom(int zoom);
+        int GetZoom() const;
+
+        // center is the pixel under the cursor inside capture, in device pixels.
+        void SetSource(const QImage &capture, const QPoint &center);
+
+    protected:
+        void paintEvent(QPaintEvent *event) override;
+
+    private:
+        void resizeBuffer();
+
+    private:
+        int m_grid_size_ { 11 };
+        int m_zoom_ { 8 };
+        QImage m_zoomed_;
+    };
+
+    // Screen geometries cached for per-tick cursor lookups. Rebuilt lazily after a screen
+    // is added, removed or changes geometry.
+    class ScreenIndex : public QObject
+    {
+        Q_OBJECT
+    public:
+        explicit ScreenIndex(QObject *parent = nullptr);
+        ~ScreenIndex() override;
+
+        // Screen containing pos (global logical coordinates), or the primary screen.
+        QScreen *ScreenAt(const QPoint &pos);
+
+    private slots:
+        void slot_invalidate();
+
+    private:
+        void rebuild();
+
+    private:
+        struct Entry
+        {
+            QRect geometry;
+            QScreen *screen;
+        };
+
+        QVector<Entry> m_entries_;
+        int m_last_hit_ { -1 };
+        bool m_valid_ { false };
+    };
+
+    // Translucent full-screen overlay for dragging out a rectangle on one screen.
+    // Escape or a right click cancels.
+    class RegionSelector : public QWidget
+    {
+        Q_OBJECT
+    public:
+        explicit RegionSelector(QWidget *parent = nullptr);
+        ~RegionSelector() override;
+
+        void Start(QScreen *screen);
+
+    signals:
+        // rect is in global logical coordinates.
+        void sig_selected(const QRect &rect);
+        void sig_canceled();
+
+    protected:
+        void paintEvent(QPaintEvent *event) override;
+        void mousePressEvent(QMouseEvent *event) override;
+        void mouseMoveEvent(QMouseEvent *event) override;
+        void mouseReleaseEvent(QMouseEvent *event) override;
+        void keyPressEvent(QKeyEvent *event) override;
+
+    private:
+        QPoint m_origin_;
+        QRect m_selection_;
+        bool m_dragging_ { false };
+    };
+
+    struct SpySampleRequest
+    {
+        QPoint cursor;
+        ScreenTarget screen;
+        // Set when the sampler is not thread-safe and the GUI thread captured for the worker.
+        QImage capture;
+        QRect capture_rect;
+        int loupe_grid { 1 };
+        int sample_size { 1 };
+        SampleReduction reduction { SampleReduction::Mean };
+    };
+
+    struct SpySampleResult
+    {
+        QPoint cursor;
+        QRgb rgb { 0 };
+        // loupe_grid x loupe_grid device pixels centred on the cursor pixel.
+        QImage loupe;
+    };
+
+    struct SpyRegionRequest
+    {
+        ScreenTarget screen;
+        QRect rect;
+        int count { 6 };
+        // Set when the sampler is not thread-safe and the GUI thread captured the region.
+        QImage capture;
+    };
+
+    struct SpyRegionResult
+    {
+        QVector<PaletteEntry> palette;
+    };
+
+    // Captures and reduces screen pixels on its own thread. Requests and results pass
+    // through LatestValue slots, so a slow capture only drops stale requests and the
+    // GUI thread never waits for it.
+    class ColorSpyWorker : public QObject
+    {
+        Q_OBJECT
+    public:
+        explicit ColorSpyWorker(QObject *parent = nullptr);
+        ~ColorSpyWorker() override;
+
+        // GUI thread: replaces the newest pending request and wakes the worker if needed.
+        void Request(const SpySampleRequest &request);
+
+        // GUI thread: newest result since the last call, or nullptr. Valid until the next call.
+        const SpySampleResult *TakeResult();
+
+        // GUI thread: the swap happens on the worker thread between two captures.
+        void SetSampler(std::shared_ptr<ScreenSampler> sampler);
+
+        // GUI thread: captures the region (unless the request carries a capture) and extracts
+        // its palette on the worker. Only the newest pending region is processed.
+        void RequestRegion(const SpyRegionRequest &request);
+        const SpyRegionResult *TakeRegion();
+
+    signals:
+        // Emitted once per batch of unread results, not for every result.
+        void sig_resultReady();
+        void sig_regionReady();
+
+    private:
+        void process();
+        void sample(const SpySampleRequest &request);
+        void processRegion();
+
+    private:
+        LatestValue<SpySampleRequest> m_requests_;
+        LatestValue<SpySampleResult> m_results_;
+        LatestValue<SpyRegionRequest> m_region_requests_;
+        LatestValue<SpyRegionResult> m_region_results_;
+        std::atomic<bool> m_process_queued_ { false };
+        std::atomic<bool> m_result_queued_ { false };
+
+        // Worker thread only.
+        std::shared_ptr<ScreenSampler> m_sampler_;
+        // Last capture, larger than the loupe so small cursor moves can reuse it.
+        QImage m_capture_;
+        QRect m_capture_rect_;
+        QPoint m_capture_cursor_pos_ { -1, -1 };
+    };
+
     class ColorSpy :public QWidget {
         Q_OBJECT
+        Q_PROPERTY(SamplingPolicy samplingPolicy READ GetSamplingPolicy WRITE SetSamplingPolicy)
+        Q_PROPERTY(qreal samplesPerSecond READ GetSamplesPerSecond)
     public:
+        // FixedRate samples every 20ms. Adaptive samples as the cursor moves and backs off
+        // to a slow refresh while it is still.
+        enum SamplingPolicy
+        {
+            FixedRate,
+            Adaptive
+        };
+        Q_ENUM(SamplingPolicy)
+
         explicit ColorSpy(QWidget *parent = nullptr);
         ~ColorSpy() override;
 
@@ -19,13 +213,52 @@ namespace Custom_Control
         void StartTimer();
         void StopTimer();
 
+        void SetSamplingPolicy(SamplingPolicy policy);
+        SamplingPolicy GetSamplingPolicy() const;
+
+        // Sample requests issued per second, measured over the last second of sampling.
+        qreal GetSamplesPerSecond() const;
+
+        // Replaces the capture backend, nullptr restores the default one. Thread-safe backends
+        // capture on the worker thread; others (GrabWindowSampler) capture on the GUI thread.
+        void SetSampler(std::unique_ptr<ScreenSampler> sampler);
+        const ScreenSampler *Sampler() const;
+
+        // Picked colour is reduced over a size x size block around the cursor pixel.
+        // size is one of 1, 3, 5 or 11; other values are ignored.
+        void SetSampleSize(int size);
+        int GetSampleSize() const;
+
+        void SetSampleReduction(SampleReduction reduction);
+        SampleReduction GetSampleReduction() const;
+
+        // Results that refreshed the swatch and text fields, and results skipped because
+        // neither the colour nor the cursor position changed.
+        qint64 GetUiUpdateCount() const;
+        qint64 GetSkippedUiUpdateCount() const;
+
+        // Region mode: the user drags a rectangle, which is captured once and reduced to
+        // up to count dominant colours, reported through sig_regionPalette. Pressing R in
+        // the spy starts it as well.
+        void StartRegionPick(int count = 6);
+
     signals:
         void sig_pickerColor(QColor color);
         void sig_timerPickerColor(QColor color);
+        // Dominant colours of the picked region, most common first; weights sum to 1.
+        void sig_regionPalette(const QVector<QColor> &colors, const QVector<qreal> &weights);
 
     private slots:
+        void slot_pollCursor();
+        void slot_resultReady();
         void slot_showColorValue();
+        void slot_regionSelected(const QRect &rect);
+        void slot_regionReady();
+        void slot_regionCanceled();
     private:
+        void requestSample();
+        void recordSample();
+        int frameInterval() const;
         void init();
         void initUI();
         void init_connection();
@@ -39,21 +272,60 @@ namespace Custom_Control
 
     private:
         QTimer *m_timer_ { nullptr };
+        std::shared_ptr<ScreenSampler> m_sampler_;
+        ScreenIndex *m_screen_index_ { nullptr };
+        // GUI-thread capture, used only with samplers that cannot run on the worker.
+        QImage m_capture_;
+        QRect m_capture_rect_;
+        QPoint m_capture_cursor_pos_ { -1, -1 };
+
+        QThread *m_worker_thread_ { nullptr };
+        ColorSpyWorker *m_worker_ { nullptr };
+
+        // Results reach the UI at most once per frame.
+        QTimer *m_frame_timer_ { nullptr };
+        QElapsedTimer m_frame_clock_;
+
+        RegionSelector *m_region_selector_ { nullptr };
+        int m_region_colors_ { 6 };
+
+        int m_sample_size_ { 1 };
+        SampleReduction m_sample_reduction_ { SampleReduction::Mean };
+
+        SamplingPolicy m_sampling_policy_ { Adaptive };
+        QPoint m_last_cursor_pos_ { -1, -1 };
+        int m_idle_refresh_interval_ { 0 };
+        QElapsedTimer m_idle_clock_;
+
+        QElapsedTimer m_rate_clock_;
+        int m_rate_sample_count_ { 0 };
+        qreal m_samples_per_second_ { 0 };
 
         QHBoxLayout *m_hlayout_ { nullptr };
 
         QGridLayout *m_grid_layout_ { nullptr };
 
         QLabel m_show_lab_;
+        ColorLoupe *m_loupe_ { nullptr };
         QLabel m_hex_lab_ { "hex" };
         QLabel m_rgb_lab_ { "rgb" };
         QLabel m_position_lab_ { "position" };
+        QLabel m_name_lab_ { "name" };
 
         QLineEdit *m_hex_edit_ { nullptr };
         QLineEdit *m_rgb_edit_ { nullptr };
         QLineEdit *m_position_edit_ { nullptr };
+        QLineEdit *m_name_edit_ { nullptr };
 
         QColor m_color_ { "#FFFFFF" };
 
+        // Last values written to the UI, used to skip unchanged ticks.
+        bool m_has_shown_ { false };
+        QRgb m_shown_rgb_ { 0 };
+        QPoint m_shown_pos_;
+        char m_text_buffer_[48];
+        qint64 m_ui_updates_ { 0 };
+        qint64 m_skipped_ui_updates_ { 0 };
+
     };
 }
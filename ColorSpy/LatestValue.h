@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+
+namespace Custom_Control
+{
+    // Lock-free single-producer/single-consumer slot that only keeps the newest value.
+    // Triple buffered: the producer fills its back slot and swaps it with the shared middle
+    // slot, the consumer swaps its front slot with the middle one when it holds fresh data.
+    // Neither side ever waits for the other, and values are written in place so slots
+    // holding buffers (QImage, containers) are reused.
+    template <typename T>
+    class LatestValue
+    {
+    public:
+        // Producer side: the slot to fill before Publish().
+        T &Back()
+        {
+            return m_slots_[m_back_];
+        }
+
+        void Publish()
+        {
+            const int old = m_middle_.exchange(m_back_ | kFresh, std::memory_order_acq_rel);
+            m_back_ = old & kIndexMask;
+        }
+
+        // Consumer side: the newest published value, or nullptr when nothing was published
+        // since the last call. The value stays valid until the next Take().
+        const T *Take()
+        {
+            if (!(m_middle_.load(std::memory_order_relaxed) & kFresh))
+                return nullptr;
+
+            const int old = m_middle_.exchange(m_front_, std::memory_order_acq_rel);
+            m_front_ = old & kIndexMask;
+            return &m_slots_[m_front_];
+        }
+
+    private:
+        static const int kIndexMask = 0x3;
+        static const int kFresh = 0x4;
+
+        T m_slots_[3];
+        int m_back_ { 0 };
+        int m_front_ { 1 };
+        std::atomic<int> m_middle_ { 2 };
+    };
+}
@@ -0,0 +1,290 @@
+#include "PaletteExtractor.h"
+#include "ColorSpace.h"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PALETTE_EXTRACTOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Custom_Control
+{
+    namespace
+    {
+        // 5 bits per channel keeps the histogram in L2 and is finer than any palette needs.
+        const int kChannelBits = 5;
+        const int kBinCount = 1 << (kChannelBits * 3);
+        const int kMinRowsPerTask = 64;
+        const int kMinPointsPerTask = 4096;
+        const int kMaxIterations = 24;
+        const float kConvergence = 1e-5f;
+
+        struct Bin
+        {
+            quint64 count;
+            quint64 red;
+            quint64 green;
+            quint64 blue;
+        };
+
+        class FunctionTask : public QRunnable
+        {
+        public:
+            explicit FunctionTask(std::function<void()> fn)
+                : m_fn_(std::move(fn))
+            {
+                setAutoDelete(true);
+            }
+
+            void run() override
+            {
+                m_fn_();
+            }
+
+        private:
+            std::function<void()> m_fn_;
+        };
+
+        int taskCount(int items, int min_items_per_task)
+        {
+            const int threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+            return qBound(1, items / min_items_per_task, threads);
+        }
+
+        // Runs fn(task, begin, end) over tasks equal slices of [0, items), the first on the
+        // calling thread, and returns once all of them have finished.
+        void parallelFor(int items, int tasks, const std::function<void(int, int, int)> &fn)
+        {
+            QSemaphore done;
+            for (int task = 1; task < tasks; ++task) {
+                const int begin = int(qint64(items) * task / tasks);
+                const int end = int(qint64(items) * (task + 1) / tasks);
+                QThreadPool::globalInstance()->start(new FunctionTask([&fn, &done, task, begin, end] {
+                    fn(task, begin, end);
+                    done.release();
+                }));
+            }
+
+            fn(0, 0, int(qint64(items) / tasks));
+            done.acquire(tasks - 1);
+        }
+
+        // Points in structure-of-arrays layout so the SSE2 path loads 4 points per register.
+        struct Points
+        {
+            std::vector<float> L;
+            std::vector<float> a;
+            std::vector<float> b;
+            std::vector<float> weight;
+            std::vector<int> bin;
+            int size = 0;
+        };
+
+        struct Centers
+        {
+            std::vector<float> L;
+            std::vector<float> a;
+            std::vector<float> b;
+        };
+
+        void assignRange(const Points &points, const Centers &centers, int begin, int end, int *assignment)
+        {
+            const int k = int(centers.L.size());
+            int i = begin;
+#ifdef PALETTE_EXTRACTOR_SSE2
+            for (; i + 4 <= end; i += 4) {
+                const __m128 pL = _mm_loadu_ps(&points.L[size_t(i)]);
+                const __m128 pa = _mm_loadu_ps(&points.a[size_t(i)]);
+                const __m128 pb = _mm_loadu_ps(&points.b[size_t(i)]);
+                __m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+                __m128i best_index = _mm_setzero_si128();
+                for (int c = 0; c < k; ++c) {
+                    const __m128 dL = _mm_sub_ps(pL, _mm_set1_ps(centers.L[size_t(c)]));
+                    const __m128 da = _mm_sub_ps(pa, _mm_set1_ps(centers.a[size_t(c)]));
+                    const __m128 db = _mm_sub_ps(pb, _mm_set1_ps(centers.b[size_t(c)]));
+                    const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dL, dL), _mm_mul_ps(da, da)), _mm_mul_ps(db, db));
+                    const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(dist, best));
+                    best = _mm_min_ps(dist, best);
+                    best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(c)), _mm_andnot_si128(closer, best_index));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(assignment + i), best_index);
+            }
+#endif
+            for (; i < end; ++i) {
+                float best = std::numeric_limits<float>::max();
+                int best_index = 0;
+                for (int c = 0; c < k; ++c) {
+                    const float dL = points.L[size_t(i)] - centers.L[size_t(c)];
+                    const float da = points.a[size_t(i)] - centers.a[size_t(c)];
+                    const float db = points.b[size_t(i)] - centers.b[size_t(c)];
+                    const float dist = dL * dL + da * da + db * db;
+                    if (dist < best) {
+                        best = dist;
+                        best_index = c;
+                    }
+                }
+                assignment[i] = best_index;
+            }
+        }
+
+        // Deterministic k-means++ style seeding: heaviest point first, then the point with
+        // the largest weight * squared distance to its nearest centre.
+        Centers seedCenters(const Points &points, int k)
+        {
+            Centers centers;
+            std::vector<float> nearest(size_t(points.size), std::numeric_limits<float>::max());
+            int next = int(std::max_element(points.weight.begin(), points.weight.begin() + points.size) - points.weight.begin());
+            for (int c = 0; c < k; ++c) {
+                centers.L.push_back(points.L[size_t(next)]);
+                centers.a.push_back(points.a[size_t(next)]);
+                centers.b.push_back(points.b[size_t(next)]);
+
+                float best_score = -1.0f;
+                for (int i = 0; i < points.size; ++i) {
+                    const float dL = points.L[size_t(i)] - centers.L.back();
+                    const float da = points.a[size_t(i)] - centers.a.back();
+                    const float db = points.b[size_t(i)] - centers.b.back();
+                    nearest[size_t(i)] = std::min(nearest[size_t(i)], dL * dL + da * da + db * db);
+
+                    const float score = nearest[size_t(i)] * points.weight[size_t(i)];
+                    if (score > best_score) {
+                        best_score = score;
+                        next = i;
+                    }
+                }
+            }
+            return centers;
+        }
+    }
+
+    QVector<PaletteEntry> ExtractPalette(const QImage &image, int count)
+    {
+        QVector<PaletteEntry> palette;
+        if (image.isNull() || image.depth() != 32 || count < 1)
+            return palette;
+
+        // Histogram: one private table per task, merged afterwards.
+        const int rows = image.height();
+        const int width = image.width();
+        const int row_tasks = taskCount(rows, kMinRowsPerTask);
+        std::vector<std::vector<Bin>> histograms(size_t(row_tasks), std::vector<Bin>(size_t(kBinCount), Bin { 0, 0, 0, 0 }));
+        parallelFor(rows, row_tasks, [&](int task, int begin, int end) {
+            Bin *bins = histograms[size_t(task)].data();
+            for (int y = begin; y < end; ++y) {
+                const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+                for (int x = 0; x < width; ++x) {
+                    const QRgb pixel = line[x];
+                    const quint32 index = ((pixel >> 9) & 0x7C00) | ((pixel >> 6) & 0x03E0) | ((pixel >> 3) & 0x001F);
+                    Bin &bin = bins[index];
+                    ++bin.count;
+                    bin.red += qRed(pixel);
+                    bin.green += qGreen(pixel);
+                    bin.blue += qBlue(pixel);
+                }
+            }
+        });
+
+        std::vector<Bin> &merged = histograms[0];
+        for (size_t task = 1; task < histograms.size(); ++task) {
+            for (int i = 0; i < kBinCount; ++i) {
+                const Bin &bin = histograms[task][size_t(i)];
+                merged[size_t(i)].count += bin.count;
+                merged[size_t(i)].red += bin.red;
+                merged[size_t(i)].green += bin.green;
+                merged[size_t(i)].blue += bin.blue;
+            }
+        }
+
+        // Occupied bins become weighted points at their mean colour.
+        Points points;
+        for (int i = 0; i < kBinCount; ++i) {
+            const Bin &bin = merged[size_t(i)];
+            if (!bin.count)
+                continue;
+
+            const OkLab lab = RgbToOkLab(qRgb(int((bin.red + bin.count / 2) / bin.count),
+                int((bin.green + bin.count / 2) / bin.count), int((bin.blue + bin.count / 2) / bin.count)));
+            points.L.push_back(lab.L);
+            points.a.push_back(lab.a);
+            points.b.push_back(lab.b);
+            points.weight.push_back(float(bin.count));
+            points.bin.push_back(i);
+        }
+        points.size = int(points.bin.size());
+        if (!points.size)
+            return palette;
+
+        const int k = qMin(count, points.size);
+        Centers centers = seedCenters(points, k);
+
+        // Lloyd iterations; the assignment step is split across the pool for large inputs.
+        std::vector<int> assignment(size_t(points.size), 0);
+        const int point_tasks = taskCount(points.size, kMinPointsPerTask);
+        for (int iteration = 0; iteration < kMaxIterations; ++iteration) {
+            parallelFor(points.size, point_tasks, [&](int, int begin, int end) {
+                assignRange(points, centers, begin, end, assignment.data());
+            });
+
+            std::vector<double> sum_L(size_t(k), 0.0), sum_a(size_t(k), 0.0), sum_b(size_t(k), 0.0), sum_w(size_t(k), 0.0);
+            for (int i = 0; i < points.size; ++i) {
+                const size_t c = size_t(assignment[size_t(i)]);
+                const double w = points.weight[size_t(i)];
+                sum_L[c] += w * points.L[size_t(i)];
+                sum_a[c] += w * points.a[size_t(i)];
+                sum_b[c] += w * points.b[size_t(i)];
+                sum_w[c] += w;
+            }
+
+            float shift = 0.0f;
+            for (int c = 0; c < k; ++c) {
+                if (sum_w[size_t(c)] <= 0.0)
+                    continue;
+
+                const float L = float(sum_L[size_t(c)] / sum_w[size_t(c)]);
+                const float a = float(sum_a[size_t(c)] / sum_w[size_t(c)]);
+                const float b = float(sum_b[size_t(c)] / sum_w[size_t(c)]);
+                shift = std::max(shift, (L - centers.L[size_t(c)]) * (L - centers.L[size_t(c)])
+                    + (a - centers.a[size_t(c)]) * (a - centers.a[size_t(c)])
+                    + (b - centers.b[size_t(c)]) * (b - centers.b[size_t(c)]));
+                centers.L[size_t(c)] = L;
+                centers.a[size_t(c)] = a;
+                centers.b[size_t(c)] = b;
+            }
+
+            if (shift < kConvergence * kConvergence)
+                break;
+        }
+
+        // Report each cluster's mean sRGB colour over its actual pixels.
+        std::vector<quint64> red(size_t(k), 0), green(size_t(k), 0), blue(size_t(k), 0), pixels(size_t(k), 0);
+        for (int i = 0; i < points.size; ++i) {
+            const size_t c = size_t(assignment[size_t(i)]);
+            const Bin &bin = merged[size_t(points.bin[size_t(i)])];
+            red[c] += bin.red;
+            green[c] += bin.green;
+            blue[c] += bin.blue;
+            pixels[c] += bin.count;
+        }
+
+        const qreal total = qreal(qint64(width) * rows);
+        for (int c = 0; c < k; ++c) {
+            const quint64 n = pixels[size_t(c)];
+            if (!n)
+                continue;
+
+            palette.append({ qRgb(int((red[size_t(c)] + n / 2) / n), int((green[size_t(c)] + n / 2) / n),
+                int((blue[size_t(c)] + n / 2) / n)), n / total });
+        }
+
+        std::sort(palette.begin(), palette.end(), [](const PaletteEntry &lhs, const PaletteEntry &rhs) {
+            return lhs.weight > rhs.weight;
+        });
+        return palette;
+    }
+}
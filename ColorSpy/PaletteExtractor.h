@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QImage>
+#include <QRgb>
+#include <QVector>
+
+namespace Custom_Control
+{
+    struct PaletteEntry
+    {
+        QRgb rgb;
+        // Share of the image's pixels in this cluster, 0..1.
+        qreal weight;
+    };
+
+    // Extracts up to count dominant colours of a 32 bits per pixel image, most common first.
+    // Pixels are binned into a 15-bit histogram on the global QThreadPool, then the occupied
+    // bins are clustered with weighted k-means in OKLab. Alpha is ignored.
+    QVector<PaletteEntry> ExtractPalette(const QImage &image, int count);
+}
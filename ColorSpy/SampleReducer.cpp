@@ -0,0 +1,98 @@
+#include "SampleReducer.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAMPLE_REDUCER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Custom_Control
+{
+    namespace
+    {
+        const int kMaxSampleSize = 11;
+
+        struct ChannelSums
+        {
+            quint32 red = 0;
+            quint32 green = 0;
+            quint32 blue = 0;
+        };
+
+        void sumRow(const QRgb *row, int count, ChannelSums &sums)
+        {
+            int x = 0;
+#ifdef SAMPLE_REDUCER_SSE2
+            // Widen 4 pixels to 16-bit lanes and fold them into [B G R A B G R A];
+            // a row of at most 11 pixels cannot overflow a lane.
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = zero;
+            for (; x + 4 <= count; x += 4) {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+                acc = _mm_add_epi16(acc, _mm_add_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_unpackhi_epi8(pixels, zero)));
+            }
+
+            alignas(16) quint16 lanes[8];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+            sums.blue += quint32(lanes[0]) + lanes[4];
+            sums.green += quint32(lanes[1]) + lanes[5];
+            sums.red += quint32(lanes[2]) + lanes[6];
+#endif
+            for (; x < count; ++x) {
+                sums.red += qRed(row[x]);
+                sums.green += qGreen(row[x]);
+                sums.blue += qBlue(row[x]);
+            }
+        }
+    }
+
+    bool IsValidSampleSize(int size)
+    {
+        return size == 1 || size == 3 || size == 5 || size == 11;
+    }
+
+    QRgb ReduceSampleBlock(const QImage &image, const QPoint &center, int size, SampleReduction reduction)
+    {
+        if (image.isNull() || image.depth() != 32 || size < 1 || size > kMaxSampleSize)
+            return qRgb(0, 0, 0);
+
+        const int half = size / 2;
+        const QRect block = QRect(center.x() - half, center.y() - half, size, size) & image.rect();
+        if (block.isEmpty())
+            return qRgb(0, 0, 0);
+
+        if (block.width() == 1 && block.height() == 1)
+            return image.pixel(block.topLeft()) | 0xFF000000u;
+
+        const int count = block.width() * block.height();
+        if (reduction == SampleReduction::Mean) {
+            ChannelSums sums;
+            for (int y = block.top(); y <= block.bottom(); ++y)
+                sumRow(reinterpret_cast<const QRgb *>(image.constScanLine(y)) + block.left(), block.width(), sums);
+
+            return qRgb(int((sums.red + count / 2) / count),
+                int((sums.green + count / 2) / count),
+                int((sums.blue + count / 2) / count));
+        }
+
+        // Per-channel median by selection on stack buffers.
+        uchar reds[kMaxSampleSize * kMaxSampleSize];
+        uchar greens[kMaxSampleSize * kMaxSampleSize];
+        uchar blues[kMaxSampleSize * kMaxSampleSize];
+        int n = 0;
+        for (int y = block.top(); y <= block.bottom(); ++y) {
+            const QRgb *row = reinterpret_cast<const QRgb *>(image.constScanLine(y)) + block.left();
+            for (int x = 0; x < block.width(); ++x, ++n) {
+                reds[n] = uchar(qRed(row[x]));
+                greens[n] = uchar(qGreen(row[x]));
+                blues[n] = uchar(qBlue(row[x]));
+            }
+        }
+
+        const int mid = count / 2;
+        std::nth_element(reds, reds + mid, reds + count);
+        std::nth_element(greens, greens + mid, greens + count);
+        std::nth_element(blues, blues + mid, blues + count);
+        return qRgb(reds[mid], greens[mid], blues[mid]);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <QImage>
+#include <QPoint>
+#include <QRgb>
+
+namespace Custom_Control
+{
+    enum class SampleReduction
+    {
+        Mean,
+        Median
+    };
+
+    // Block sizes ColorSpy offers: 1x1, 3x3, 5x5 and 11x11.
+    bool IsValidSampleSize(int size);
+
+    // Reduces the size x size block centred on center (device pixels) to one opaque colour.
+    // The block is clipped to the image; image must be 32 bits per pixel.
+    QRgb ReduceSampleBlock(const QImage &image, const QPoint &center, int size, SampleReduction reduction);
+}
@@ -0,0 +1,411 @@
+#include "ScreenSampler.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QPixmap>
+#include <QThread>
+#include <QtMath>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#endif
+
+#ifdef CUSTOM_CONTROL_XSHM
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
+
+namespace Custom_Control
+{
+    namespace
+    {
+        QImage toRgb32(const QImage &image)
+        {
+            switch (image.format()) {
+            case QImage::Format_RGB32:
+            case QImage::Format_ARGB32:
+            case QImage::Format_ARGB32_Premultiplied:
+                return image;
+            default:
+                return image.convertToFormat(QImage::Format_RGB32);
+            }
+        }
+
+        // Looks the screen up again by identity, it may have been removed since the target was taken.
+        QScreen *resolveScreen(const ScreenTarget &target)
+        {
+            const QList<QScreen *> screens = QGuiApplication::screens();
+            for (QScreen *screen : screens) {
+                if (screen->name() == target.name && screen->serialNumber() == target.serial_number
+                    && screen->geometry() == target.geometry)
+                    return screen;
+            }
+            return nullptr;
+        }
+
+#if defined(CUSTOM_CONTROL_XSHM) || defined(Q_OS_WIN)
+        // Native backends address the whole desktop in device pixels. Each screen keeps its
+        // native origin and scales by its own ratio from there.
+        QRect toNative(const ScreenTarget &screen, const QRect &logical)
+        {
+            const qreal dpr = screen.device_pixel_ratio;
+            const QPoint origin = screen.geometry.topLeft();
+            return QRect(origin + (logical.topLeft() - origin) * dpr, logical.size() * dpr);
+        }
+
+        QRect fromNative(const ScreenTarget &screen, const QRect &native)
+        {
+            const qreal dpr = screen.device_pixel_ratio;
+            const QPoint origin = screen.geometry.topLeft();
+            const QPoint offset = native.topLeft() - origin;
+            return QRect(origin + QPoint(qFloor(offset.x() / dpr), qFloor(offset.y() / dpr)), native.size() / dpr);
+        }
+#endif
+
+#ifdef CUSTOM_CONTROL_XSHM
+        // Reads the root window through a private Xlib connection into a reused
+        // shared-memory XImage, avoiding the per-call image transfer over the socket.
+        class XShmSampler : public ScreenSampler
+        {
+        public:
+            XShmSampler()
+            {
+                m_display_ = XOpenDisplay(nullptr);
+                if (!m_display_)
+                    return;
+
+                if (!XShmQueryExtension(m_display_)) {
+                    XCloseDisplay(m_display_);
+                    m_display_ = nullptr;
+                    return;
+                }
+
+                m_root_ = DefaultRootWindow(m_display_);
+            }
+
+            ~XShmSampler() override
+            {
+                releaseImage();
+                if (m_display_)
+                    XCloseDisplay(m_display_);
+            }
+
+            bool IsValid() const
+            {
+                return m_display_ != nullptr;
+            }
+
+            const char *Name() const override
+            {
+                return "xshm";
+            }
+
+            // Uses its own display connection and no Qt GUI objects.
+            bool IsThreadSafe() const override
+            {
+                return true;
+            }
+
+            QImage Grab(const ScreenTarget &screen, const QRect &rect, QRect *grabbed_rect) override
+            {
+                if (!m_display_ || screen.geometry.isEmpty())
+                    return QImage();
+
+                // Out-of-bounds XShmGetImage raises BadMatch, so clip to the screen first.
+                const QRect logical = rect & screen.geometry;
+                if (logical.isEmpty())
+                    return QImage();
+
+                const QRect root_rect(0, 0, DisplayWidth(m_display_, DefaultScreen(m_display_)),
+                    DisplayHeight(m_display_, DefaultScreen(m_display_)));
+                const QRect native_rect = toNative(screen, logical) & root_rect;
+                if (native_rect.isEmpty())
+                    return QImage();
+
+                if (!ensureImage(native_rect.size()))
+                    return QImage();
+
+                if (!XShmGetImage(m_display_, m_root_, m_image_, native_rect.x(), native_rect.y(), AllPlanes))
+                    return QImage();
+
+                if (grabbed_rect)
+                    *grabbed_rect = fromNative(screen, native_rect);
+
+                // Zero-copy view of the shared segment.
+                QImage image(reinterpret_cast<const uchar *>(m_image_->data), m_image_->width, m_image_->height,
+                    m_image_->bytes_per_line, QImage::Format_RGB32);
+                image.setDevicePixelRatio(screen.device_pixel_ratio);
+                return image;
+            }
+
+        private:
+            bool ensureImage(const QSize &size)
+            {
+                if (m_image_ && m_image_->width == size.width() && m_image_->height == size.height())
+                    return true;
+
+                releaseImage();
+
+                const int screen_number = DefaultScreen(m_display_);
+                m_image_ = XShmCreateImage(m_display_, DefaultVisual(m_display_, screen_number),
+                    DefaultDepth(m_display_, screen_number), ZPixmap, nullptr, &m_shm_info_,
+                    size.width(), size.height());
+                if (!m_image_)
+                    return false;
+
+                // Only 32bpp little-endian visuals map directly onto QImage::Format_RGB32.
+                if (m_image_->bits_per_pixel != 32 || m_image_->byte_order != LSBFirst) {
+                    XDestroyImage(m_image_);
+                    m_image_ = nullptr;
+                    return false;
+                }
+
+                m_shm_info_.shmid = shmget(IPC_PRIVATE, size_t(m_image_->bytes_per_line) * m_image_->height,
+                    IPC_CREAT | 0600);
+                if (m_shm_info_.shmid < 0) {
+                    XDestroyImage(m_image_);
+                    m_image_ = nullptr;
+                    return false;
+                }
+
+                m_shm_info_.shmaddr = m_image_->data = static_cast<char *>(shmat(m_shm_info_.shmid, nullptr, 0));
+                m_shm_info_.readOnly = False;
+                if (m_shm_info_.shmaddr == reinterpret_cast<char *>(-1) || !XShmAttach(m_display_, &m_shm_info_)) {
+                    shmctl(m_shm_info_.shmid, IPC_RMID, nullptr);
+                    m_image_->data = nullptr;
+                    XDestroyImage(m_image_);
+                    m_image_ = nullptr;
+                    return false;
+                }
+
+                // The segment is freed automatically once both sides detach.
+                XSync(m_display_, False);
+                shmctl(m_shm_info_.shmid, IPC_RMID, nullptr);
+                return true;
+            }
+
+            void releaseImage()
+            {
+                if (!m_image_)
+                    return;
+
+                XShmDetach(m_display_, &m_shm_info_);
+                XSync(m_display_, False);
+                shmdt(m_shm_info_.shmaddr);
+                m_image_->data = nullptr;
+                XDestroyImage(m_image_);
+                m_image_ = nullptr;
+            }
+
+        private:
+            Display *m_display_ { nullptr };
+            Window m_root_ { 0 };
+            XImage *m_image_ { nullptr };
+            XShmSegmentInfo m_shm_info_ {};
+        };
+#endif
+
+#ifdef Q_OS_WIN
+        // BitBlts the desktop into a reused DIB section. GDI needs no Qt GUI objects, and the
+        // screen DC is taken per call on the calling thread, so it can run on the worker.
+        class GdiSampler : public ScreenSampler
+        {
+        public:
+            ~GdiSampler() override
+            {
+                releaseImage();
+            }
+
+            const char *Name() const override
+            {
+                return "gdi";
+            }
+
+            bool IsThreadSafe() const override
+            {
+                return true;
+            }
+
+            QImage Grab(const ScreenTarget &screen, const QRect &rect, QRect *grabbed_rect) override
+            {
+                if (screen.geometry.isEmpty())
+                    return QImage();
+
+                const QRect logical = rect & screen.geometry;
+                if (logical.isEmpty())
+                    return QImage();
+
+                // Qt runs per-monitor DPI aware, so the virtual desktop is in device pixels.
+                const QRect desktop(GetSystemMetrics(SM_XVIRTUALSCREEN), GetSystemMetrics(SM_YVIRTUALSCREEN),
+                    GetSystemMetrics(SM_CXVIRTUALSCREEN), GetSystemMetrics(SM_CYVIRTUALSCREEN));
+                const QRect native_rect = toNative(screen, logical) & desktop;
+                if (native_rect.isEmpty())
+                    return QImage();
+
+                if (!ensureImage(native_rect.size()))
+                    return QImage();
+
+                HDC screen_dc = GetDC(nullptr);
+                if (!screen_dc)
+                    return QImage();
+
+                const BOOL copied = BitBlt(m_memory_dc_, 0, 0, native_rect.width(), native_rect.height(),
+                    screen_dc, native_rect.x(), native_rect.y(), SRCCOPY | CAPTUREBLT);
+                ReleaseDC(nullptr, screen_dc);
+                GdiFlush();
+                if (!copied)
+                    return QImage();
+
+                if (grabbed_rect)
+                    *grabbed_rect = fromNative(screen, native_rect);
+
+                // Zero-copy view of the top-down DIB section.
+                QImage image(static_cast<const uchar *>(m_bits_), m_size_.width(), m_size_.height(),
+                    m_size_.width() * 4, QImage::Format_RGB32);
+                image.setDevicePixelRatio(screen.device_pixel_ratio);
+                return image;
+            }
+
+        private:
+            bool ensureImage(const QSize &size)
+            {
+                if (m_bitmap_ && m_size_ == size)
+                    return true;
+
+                releaseImage();
+
+                BITMAPINFO info {};
+                info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+                info.bmiHeader.biWidth = size.width();
+                info.bmiHeader.biHeight = -size.height();
+                info.bmiHeader.biPlanes = 1;
+                info.bmiHeader.biBitCount = 32;
+                info.bmiHeader.biCompression = BI_RGB;
+
+                m_memory_dc_ = CreateCompatibleDC(nullptr);
+                if (!m_memory_dc_)
+                    return false;
+
+                m_bitmap_ = CreateDIBSection(m_memory_dc_, &info, DIB_RGB_COLORS, &m_bits_, nullptr, 0);
+                if (!m_bitmap_) {
+                    releaseImage();
+                    return false;
+                }
+
+                m_old_bitmap_ = SelectObject(m_memory_dc_, m_bitmap_);
+                m_size_ = size;
+                return true;
+            }
+
+            void releaseImage()
+            {
+                if (m_memory_dc_ && m_old_bitmap_)
+                    SelectObject(m_memory_dc_, m_old_bitmap_);
+                if (m_bitmap_)
+                    DeleteObject(m_bitmap_);
+                if (m_memory_dc_)
+                    DeleteDC(m_memory_dc_);
+
+                m_memory_dc_ = nullptr;
+                m_bitmap_ = nullptr;
+                m_old_bitmap_ = nullptr;
+                m_bits_ = nullptr;
+                m_size_ = QSize();
+            }
+
+        private:
+            HDC m_memory_dc_ { nullptr };
+            HBITMAP m_bitmap_ { nullptr };
+            HGDIOBJ m_old_bitmap_ { nullptr };
+            void *m_bits_ { nullptr };
+            QSize m_size_;
+        };
+#endif
+    }
+
+    ScreenTarget ScreenTarget::FromScreen(const QScreen *screen)
+    {
+        ScreenTarget target;
+        if (!screen)
+            return target;
+
+        target.geometry = screen->geometry();
+        target.device_pixel_ratio = screen->devicePixelRatio();
+        target.name = screen->name();
+        target.serial_number = screen->serialNumber();
+        target.screen = const_cast<QScreen *>(screen);
+        return target;
+    }
+
+    const char *GrabWindowSampler::Name() const
+    {
+        return "grabWindow";
+    }
+
+    bool GrabWindowSampler::IsThreadSafe() const
+    {
+        return false;
+    }
+
+    QImage GrabWindowSampler::Grab(const ScreenTarget &target, const QRect &rect, QRect *grabbed_rect)
+    {
+        Q_ASSERT(QThread::currentThread() == qApp->thread());
+        if (QThread::currentThread() != qApp->thread())
+            return QImage();
+
+        // The caller's screen is used as is; a target without one, or whose screen has gone
+        // away, is looked up again by identity.
+        QScreen *screen = target.screen ? target.screen.data() : resolveScreen(target);
+        if (!screen)
+            return QImage();
+
+        const QRect clipped = rect & screen->geometry();
+        if (clipped.isEmpty())
+            return QImage();
+
+        // Qt 6 takes desktop grab coordinates relative to the screen, Qt 5 relative to the virtual desktop.
+#if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
+        const QPoint grab_pos = clipped.topLeft() - screen->geometry().topLeft();
+#else
+        const QPoint grab_pos = clipped.topLeft();
+#endif
+        const QPixmap pixmap = screen->grabWindow(0, grab_pos.x(), grab_pos.y(), clipped.width(), clipped.height());
+        if (pixmap.isNull())
+            return QImage();
+
+        m_image_ = toRgb32(pixmap.toImage());
+        m_image_.setDevicePixelRatio(screen->devicePixelRatio());
+        if (grabbed_rect)
+            *grabbed_rect = clipped;
+
+        return m_image_;
+    }
+
+    std::unique_ptr<ScreenSampler> CreateXShmSampler()
+    {
+#ifdef CUSTOM_CONTROL_XSHM
+        if (QGuiApplication::platformName() == QLatin1String("xcb")) {
+            std::unique_ptr<XShmSampler> sampler(new XShmSampler());
+            if (sampler->IsValid())
+                return std::unique_ptr<ScreenSampler>(sampler.release());
+        }
+#endif
+        return nullptr;
+    }
+
+    std::unique_ptr<ScreenSampler> CreateScreenSampler()
+    {
+        std::unique_ptr<ScreenSampler> sampler = CreateXShmSampler();
+        if (sampler)
+            return sampler;
+
+#ifdef Q_OS_WIN
+        if (QGuiApplication::platformName() == QLatin1String("windows"))
+            return std::unique_ptr<ScreenSampler>(new GdiSampler());
+#endif
+
+        return std::unique_ptr<ScreenSampler>(new GrabWindowSampler());
+    }
+}
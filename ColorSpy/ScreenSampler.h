@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QImage>
+#include <QPointer>
+#include <QRect>
+#include <QString>
+#include <memory>
+
+class QScreen;
+
+namespace Custom_Control
+{
+    // A screen described by value, so it can be handed to another thread. QScreen itself
+    // may only be touched on the GUI thread and can be deleted there at any time.
+    struct ScreenTarget
+    {
+        QRect geometry;
+        qreal device_pixel_ratio { 1 };
+        QString name;
+        QString serial_number;
+        // Read only on the GUI thread, by backends that go through QScreen. Other threads
+        // may copy the target but must not dereference it.
+        QPointer<QScreen> screen;
+
+        // GUI thread only.
+        static ScreenTarget FromScreen(const QScreen *screen);
+    };
+
+    // Reads a block of screen pixels. Implementations keep their buffers between calls,
+    // so the returned image is only valid until the next Grab().
+    class ScreenSampler
+    {
+    public:
+        virtual ~ScreenSampler() = default;
+
+        virtual const char *Name() const = 0;
+
+        // Whether Grab() may be called from a thread other than the GUI thread. Backends that
+        // go through QScreen return false and have to be driven from the GUI thread.
+        virtual bool IsThreadSafe() const = 0;
+
+        // rect is in global logical coordinates. The capture is clipped to screen, which should
+        // be the screen under rect; grabbed_rect receives the logical area actually returned.
+        // The image carries the screen's device pixel ratio.
+        virtual QImage Grab(const ScreenTarget &screen, const QRect &rect, QRect *grabbed_rect = nullptr) = 0;
+    };
+
+    // Portable backend built on QScreen::grabWindow. GUI thread only.
+    class GrabWindowSampler : public ScreenSampler
+    {
+    public:
+        const char *Name() const override;
+        bool IsThreadSafe() const override;
+        QImage Grab(const ScreenTarget &screen, const QRect &rect, QRect *grabbed_rect = nullptr) override;
+
+    private:
+        QImage m_image_;
+    };
+
+    // The X11 MIT-SHM backend, or nullptr when it is not compiled in or the display
+    // does not support it.
+    std::unique_ptr<ScreenSampler> CreateXShmSampler();
+
+    // Picks the fastest backend available at runtime. The X11 MIT-SHM backend is
+    // compiled in with CUSTOM_CONTROL_XSHM (link X11 and Xext) and used on the xcb platform;
+    // a GDI backend is used on Windows. Both are thread-safe. Elsewhere (macOS, Wayland, ...)
+    // only GrabWindowSampler is available, and its captures run on the GUI thread.
+    std::unique_ptr<ScreenSampler> CreateScreenSampler();
+}
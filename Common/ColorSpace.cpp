@@ -0,0 +1,550 @@
+#include "ColorSpace.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLOR_SPACE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Custom_Control
+{
+    namespace
+    {
+        // 编译期数学函数，只用于生成查找表
+        constexpr double kLn2 = 0.69314718055994530942;
+
+        constexpr double constLn(double x)
+        {
+            // 归一化到[1, 2)后用atanh级数展开
+            int exponent = 0;
+            while (x >= 2.0) {
+                x *= 0.5;
+                ++exponent;
+            }
+            while (x < 1.0) {
+                x *= 2.0;
+                --exponent;
+            }
+
+            const double t = (x - 1.0) / (x + 1.0);
+            double term = t;
+            double sum = 0.0;
+            for (int n = 1; n < 40; n += 2) {
+                sum += term / n;
+                term *= t * t;
+            }
+            return 2.0 * sum + exponent * kLn2;
+        }
+
+        constexpr double constExp(double x)
+        {
+            // x = k*ln2 + r，|r| < ln2
+            int k = int(x / kLn2);
+            const double r = x - k * kLn2;
+            double term = 1.0;
+            double sum = 1.0;
+            for (int n = 1; n < 20; ++n) {
+                term *= r / n;
+                sum += term;
+            }
+            for (; k > 0; --k)
+                sum *= 2.0;
+            for (; k < 0; ++k)
+                sum *= 0.5;
+            return sum;
+        }
+
+        constexpr double constPow(double base, double exponent)
+        {
+            return base <= 0.0 ? 0.0 : constExp(exponent * constLn(base));
+        }
+
+        constexpr double srgbDecode(double c)
+        {
+            return c <= 0.04045 ? c / 12.92 : constPow((c + 0.055) / 1.055, 2.4);
+        }
+
+        // 8位sRGB -> 线性
+        struct DecodeTable
+        {
+            float values[256];
+
+            constexpr DecodeTable()
+                : values()
+            {
+                for (int i = 0; i < 256; ++i)
+                    values[i] = float(srgbDecode(i / 255.0));
+            }
+        };
+
+        // 12位线性 -> 8位sRGB，误差不超过1
+        // 4096项超出编译器的常量求值步数限制，改在静态初始化时用std::pow生成
+        const int kEncodeBits = 12;
+        const int kEncodeMax = (1 << kEncodeBits) - 1;
+
+        struct EncodeTable
+        {
+            unsigned char values[kEncodeMax + 1];
+
+            EncodeTable()
+            {
+                for (int i = 0; i <= kEncodeMax; ++i) {
+                    const double c = double(i) / kEncodeMax;
+                    const double encoded = c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+                    values[i] = static_cast<unsigned char>(encoded * 255.0 + 0.5);
+                }
+            }
+        };
+
+        constexpr DecodeTable kDecodeTable;
+        const EncodeTable kEncodeTable;
+
+        const float kGamutEpsilon = 1e-4f;
+        const float kDegreesPerRadian = 57.29577951308232f;
+        const int kChunk = 256;
+
+        unsigned char encodeChannel(float linear)
+        {
+            const int index = int(std::min(std::max(linear, 0.0f), 1.0f) * kEncodeMax + 0.5f);
+            return kEncodeTable.values[index];
+        }
+
+        float srgbToLinear(float c)
+        {
+            return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float linearToSrgb(float c)
+        {
+            return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        }
+
+        // ---- 线性RGB <-> OKLab ----
+
+        void linearToOkLabScalar(const ColorTriple &in, ColorTriple &out)
+        {
+            const float l = std::cbrt(0.4122214708f * in.c0 + 0.5363325363f * in.c1 + 0.0514459929f * in.c2);
+            const float m = std::cbrt(0.2119034982f * in.c0 + 0.6806995451f * in.c1 + 0.1073969566f * in.c2);
+            const float s = std::cbrt(0.0883024619f * in.c0 + 0.2817188376f * in.c1 + 0.6299787005f * in.c2);
+
+            out.c0 = 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s;
+            out.c1 = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+            out.c2 = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+        }
+
+        void okLabToLinearScalar(const ColorTriple &in, ColorTriple &out)
+        {
+            const float l_ = in.c0 + 0.3963377774f * in.c1 + 0.2158037573f * in.c2;
+            const float m_ = in.c0 - 0.1055613458f * in.c1 - 0.0638541728f * in.c2;
+            const float s_ = in.c0 - 0.0894841775f * in.c1 - 1.2914855480f * in.c2;
+            const float l = l_ * l_ * l_;
+            const float m = m_ * m_ * m_;
+            const float s = s_ * s_ * s_;
+
+            out.c0 = 4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s;
+            out.c1 = -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s;
+            out.c2 = -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s;
+        }
+
+#ifdef COLOR_SPACE_SSE2
+        // 位运算初值加三次牛顿迭代，精度达到float分辨率；负数按符号对称处理
+        __m128 cbrtPs(__m128 x)
+        {
+            const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000u)));
+            const __m128 sign = _mm_and_ps(x, sign_mask);
+            const __m128 ax = _mm_andnot_ps(sign_mask, x);
+
+            // SSE2没有32位整数除法，借float完成 bits / 3
+            const __m128i bits = _mm_castps_si128(ax);
+            const __m128i third = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.0f / 3.0f)));
+            __m128 y = _mm_castsi128_ps(_mm_add_epi32(third, _mm_set1_epi32(0x2a514067)));
+
+            const __m128 third_ps = _mm_set1_ps(1.0f / 3.0f);
+            const __m128 tiny = _mm_set1_ps(1e-30f);
+            for (int i = 0; i < 3; ++i) {
+                const __m128 y2 = _mm_max_ps(_mm_mul_ps(y, y), tiny);
+                y = _mm_mul_ps(_mm_add_ps(_mm_add_ps(y, y), _mm_div_ps(ax, y2)), third_ps);
+            }
+
+            return _mm_or_ps(y, sign);
+        }
+
+        void load4(const ColorTriple *src, __m128 &c0, __m128 &c1, __m128 &c2)
+        {
+            c0 = _mm_setr_ps(src[0].c0, src[1].c0, src[2].c0, src[3].c0);
+            c1 = _mm_setr_ps(src[0].c1, src[1].c1, src[2].c1, src[3].c1);
+            c2 = _mm_setr_ps(src[0].c2, src[1].c2, src[2].c2, src[3].c2);
+        }
+
+        void store4(ColorTriple *dst, __m128 c0, __m128 c1, __m128 c2)
+        {
+            alignas(16) float v0[4], v1[4], v2[4];
+            _mm_store_ps(v0, c0);
+            _mm_store_ps(v1, c1);
+            _mm_store_ps(v2, c2);
+            for (int i = 0; i < 4; ++i)
+                dst[i] = { v0[i], v1[i], v2[i] };
+        }
+
+        __m128 dot3(__m128 x, __m128 y, __m128 z, float a, float b, float c)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(a)), _mm_mul_ps(y, _mm_set1_ps(b))),
+                _mm_mul_ps(z, _mm_set1_ps(c)));
+        }
+#endif
+
+        void linearToOkLab(const ColorTriple *src, ColorTriple *dst, int count)
+        {
+            int i = 0;
+#ifdef COLOR_SPACE_SSE2
+            for (; i + 4 <= count; i += 4) {
+                __m128 r, g, b;
+                load4(src + i, r, g, b);
+                const __m128 l = cbrtPs(dot3(r, g, b, 0.4122214708f, 0.5363325363f, 0.0514459929f));
+                const __m128 m = cbrtPs(dot3(r, g, b, 0.2119034982f, 0.6806995451f, 0.1073969566f));
+                const __m128 s = cbrtPs(dot3(r, g, b, 0.0883024619f, 0.2817188376f, 0.6299787005f));
+                store4(dst + i,
+                    dot3(l, m, s, 0.2104542553f, 0.7936177850f, -0.0040720468f),
+                    dot3(l, m, s, 1.9779984951f, -2.4285922050f, 0.4505937099f),
+                    dot3(l, m, s, 0.0259040371f, 0.7827717662f, -0.8086757660f));
+            }
+#endif
+            for (; i < count; ++i)
+                linearToOkLabScalar(src[i], dst[i]);
+        }
+
+        void okLabToLinear(const ColorTriple *src, ColorTriple *dst, int count)
+        {
+            int i = 0;
+#ifdef COLOR_SPACE_SSE2
+            for (; i + 4 <= count; i += 4) {
+                __m128 L, a, b;
+                load4(src + i, L, a, b);
+                const __m128 l_ = dot3(L, a, b, 1.0f, 0.3963377774f, 0.2158037573f);
+                const __m128 m_ = dot3(L, a, b, 1.0f, -0.1055613458f, -0.0638541728f);
+                const __m128 s_ = dot3(L, a, b, 1.0f, -0.0894841775f, -1.2914855480f);
+                const __m128 l = _mm_mul_ps(_mm_mul_ps(l_, l_), l_);
+                const __m128 m = _mm_mul_ps(_mm_mul_ps(m_, m_), m_);
+                const __m128 s = _mm_mul_ps(_mm_mul_ps(s_, s_), s_);
+                store4(dst + i,
+                    dot3(l, m, s, 4.0767416621f, -3.3077115913f, 0.2309699292f),
+                    dot3(l, m, s, -1.2684380046f, 2.6097574011f, -0.3413193965f),
+                    dot3(l, m, s, -0.0041960863f, -0.7034186147f, 1.7076147010f));
+            }
+#endif
+            for (; i < count; ++i)
+                okLabToLinearScalar(src[i], dst[i]);
+        }
+
+        // ---- 极坐标 ----
+
+        void labToLch(ColorTriple &c)
+        {
+            const float chroma = std::sqrt(c.c1 * c.c1 + c.c2 * c.c2);
+            float hue = std::atan2(c.c2, c.c1) * kDegreesPerRadian;
+            if (hue < 0)
+                hue += 360.0f;
+            c = { c.c0, chroma, hue };
+        }
+
+        void lchToLab(ColorTriple &c)
+        {
+            const float radians = c.c2 / kDegreesPerRadian;
+            c = { c.c0, c.c1 * std::cos(radians), c.c1 * std::sin(radians) };
+        }
+
+        // ---- sRGB(非线性) <-> HSV / HSL ----
+
+        void srgbToHsv(ColorTriple &c)
+        {
+            const float max = std::max(c.c0, std::max(c.c1, c.c2));
+            const float min = std::min(c.c0, std::min(c.c1, c.c2));
+            const float delta = max - min;
+
+            float hue = 0.0f;
+            if (delta > 0) {
+                if (max == c.c0)
+                    hue = 60.0f * std::fmod((c.c1 - c.c2) / delta + 6.0f, 6.0f);
+                else if (max == c.c1)
+                    hue = 60.0f * ((c.c2 - c.c0) / delta + 2.0f);
+                else
+                    hue = 60.0f * ((c.c0 - c.c1) / delta + 4.0f);
+            }
+            c = { hue, max > 0 ? delta / max : 0.0f, max };
+        }
+
+        void hueToSrgb(float hue, float chroma, float offset, ColorTriple &c)
+        {
+            const float h = std::fmod(std::fmod(hue, 360.0f) + 360.0f, 360.0f) / 60.0f;
+            const float x = chroma * (1.0f - std::fabs(std::fmod(h, 2.0f) - 1.0f));
+            float r = 0, g = 0, b = 0;
+            switch (int(h)) {
+            case 0: r = chroma; g = x; break;
+            case 1: r = x; g = chroma; break;
+            case 2: g = chroma; b = x; break;
+            case 3: g = x; b = chroma; break;
+            case 4: r = x; b = chroma; break;
+            default: r = chroma; b = x; break;
+            }
+            c = { r + offset, g + offset, b + offset };
+        }
+
+        void hsvToSrgb(ColorTriple &c)
+        {
+            const float chroma = c.c2 * c.c1;
+            hueToSrgb(c.c0, chroma, c.c2 - chroma, c);
+        }
+
+        void srgbToHsl(ColorTriple &c)
+        {
+            const float max = std::max(c.c0, std::max(c.c1, c.c2));
+            const float min = std::min(c.c0, std::min(c.c1, c.c2));
+            const float lightness = (max + min) * 0.5f;
+            const float delta = max - min;
+            ColorTriple hsv = c;
+            srgbToHsv(hsv);
+            const float saturation = delta > 0 ? delta / (1.0f - std::fabs(2.0f * lightness - 1.0f)) : 0.0f;
+            c = { hsv.c0, saturation, lightness };
+        }
+
+        void hslToSrgb(ColorTriple &c)
+        {
+            const float chroma = (1.0f - std::fabs(2.0f * c.c2 - 1.0f)) * c.c1;
+            hueToSrgb(c.c0, chroma, c.c2 - chroma * 0.5f, c);
+        }
+
+        // ---- 线性RGB <-> CIELAB(D65) ----
+
+        const float kLabDelta = 6.0f / 29.0f;
+
+        float labF(float t)
+        {
+            return t > kLabDelta * kLabDelta * kLabDelta ? std::cbrt(t) : t / (3.0f * kLabDelta * kLabDelta) + 4.0f / 29.0f;
+        }
+
+        float labFInverse(float t)
+        {
+            return t > kLabDelta ? t * t * t : 3.0f * kLabDelta * kLabDelta * (t - 4.0f / 29.0f);
+        }
+
+        void linearToCieLab(ColorTriple &c)
+        {
+            const float x = (0.4124564f * c.c0 + 0.3575761f * c.c1 + 0.1804375f * c.c2) / 0.95047f;
+            const float y = 0.2126729f * c.c0 + 0.7151522f * c.c1 + 0.0721750f * c.c2;
+            const float z = (0.0193339f * c.c0 + 0.1191920f * c.c1 + 0.9503041f * c.c2) / 1.08883f;
+            const float fx = labF(x), fy = labF(y), fz = labF(z);
+            c = { 116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz) };
+        }
+
+        void cieLabToLinear(ColorTriple &c)
+        {
+            const float fy = (c.c0 + 16.0f) / 116.0f;
+            const float x = labFInverse(fy + c.c1 / 500.0f) * 0.95047f;
+            const float y = labFInverse(fy);
+            const float z = labFInverse(fy - c.c2 / 200.0f) * 1.08883f;
+            c = { 3.2404542f * x - 1.5371385f * y - 0.4985314f * z,
+                -0.9692660f * x + 1.8760108f * y + 0.0415560f * z,
+                0.0556434f * x - 0.2040259f * y + 1.0572252f * z };
+        }
+
+        // ---- 经由线性RGB的中转 ----
+
+        void toLinear(ColorSpaceId from, const ColorTriple *src, ColorTriple *dst, int count)
+        {
+            switch (from) {
+            case ColorSpaceId::LinearRgb:
+                std::copy(src, src + count, dst);
+                return;
+            case ColorSpaceId::OkLab:
+                okLabToLinear(src, dst, count);
+                return;
+            case ColorSpaceId::OkLch:
+                for (int i = 0; i < count; ++i) {
+                    dst[i] = src[i];
+                    lchToLab(dst[i]);
+                }
+                okLabToLinear(dst, dst, count);
+                return;
+            case ColorSpaceId::CieLab:
+                for (int i = 0; i < count; ++i) {
+                    dst[i] = src[i];
+                    cieLabToLinear(dst[i]);
+                }
+                return;
+            default:
+                break;
+            }
+
+            for (int i = 0; i < count; ++i) {
+                ColorTriple c = src[i];
+                if (from == ColorSpaceId::Hsv)
+                    hsvToSrgb(c);
+                else if (from == ColorSpaceId::Hsl)
+                    hslToSrgb(c);
+                dst[i] = { srgbToLinear(c.c0), srgbToLinear(c.c1), srgbToLinear(c.c2) };
+            }
+        }
+
+        void fromLinear(const ColorTriple *src, ColorSpaceId to, ColorTriple *dst, int count)
+        {
+            switch (to) {
+            case ColorSpaceId::LinearRgb:
+                std::copy(src, src + count, dst);
+                return;
+            case ColorSpaceId::OkLab:
+                linearToOkLab(src, dst, count);
+                return;
+            case ColorSpaceId::OkLch:
+                linearToOkLab(src, dst, count);
+                for (int i = 0; i < count; ++i)
+                    labToLch(dst[i]);
+                return;
+            case ColorSpaceId::CieLab:
+                for (int i = 0; i < count; ++i) {
+                    dst[i] = src[i];
+                    linearToCieLab(dst[i]);
+                }
+                return;
+            default:
+                break;
+            }
+
+            for (int i = 0; i < count; ++i) {
+                ColorTriple c = { linearToSrgb(src[i].c0), linearToSrgb(src[i].c1), linearToSrgb(src[i].c2) };
+                if (to == ColorSpaceId::Hsv)
+                    srgbToHsv(c);
+                else if (to == ColorSpaceId::Hsl)
+                    srgbToHsl(c);
+                dst[i] = c;
+            }
+        }
+    }
+
+    float SrgbToLinear(int channel)
+    {
+        return kDecodeTable.values[channel & 0xFF];
+    }
+
+    OkLab RgbToOkLab(QRgb rgb)
+    {
+        const ColorTriple linear = { kDecodeTable.values[qRed(rgb)], kDecodeTable.values[qGreen(rgb)],
+            kDecodeTable.values[qBlue(rgb)] };
+        ColorTriple lab;
+        linearToOkLabScalar(linear, lab);
+        return { lab.c0, lab.c1, lab.c2 };
+    }
+
+    float OkLabDistance(const OkLab &lhs, const OkLab &rhs)
+    {
+        const float dL = lhs.L - rhs.L;
+        const float da = lhs.a - rhs.a;
+        const float db = lhs.b - rhs.b;
+        return std::sqrt(dL * dL + da * da + db * db);
+    }
+
+    void ConvertColors(ColorSpaceId from, const ColorTriple *src, ColorSpaceId to, ColorTriple *dst, int count)
+    {
+        if (from == to) {
+            std::copy(src, src + count, dst);
+            return;
+        }
+
+        // sRGB与HSV/HSL之间不必经过线性RGB
+        const bool gamma_only = (from == ColorSpaceId::Srgb || from == ColorSpaceId::Hsv || from == ColorSpaceId::Hsl)
+            && (to == ColorSpaceId::Srgb || to == ColorSpaceId::Hsv || to == ColorSpaceId::Hsl);
+        if (gamma_only) {
+            for (int i = 0; i < count; ++i) {
+                ColorTriple c = src[i];
+                if (from == ColorSpaceId::Hsv)
+                    hsvToSrgb(c);
+                else if (from == ColorSpaceId::Hsl)
+                    hslToSrgb(c);
+
+                if (to == ColorSpaceId::Hsv)
+                    srgbToHsv(c);
+                else if (to == ColorSpaceId::Hsl)
+                    srgbToHsl(c);
+                dst[i] = c;
+            }
+            return;
+        }
+
+        ColorTriple linear[kChunk];
+        for (int begin = 0; begin < count; begin += kChunk) {
+            const int n = std::min(kChunk, count - begin);
+            toLinear(from, src + begin, linear, n);
+            fromLinear(linear, to, dst + begin, n);
+        }
+    }
+
+    void ConvertFromRgb(const QRgb *src, ColorSpaceId to, ColorTriple *dst, int count)
+    {
+        ColorTriple linear[kChunk];
+        for (int begin = 0; begin < count; begin += kChunk) {
+            const int n = std::min(kChunk, count - begin);
+            if (to == ColorSpaceId::Srgb || to == ColorSpaceId::Hsv || to == ColorSpaceId::Hsl) {
+                for (int i = 0; i < n; ++i) {
+                    const QRgb rgb = src[begin + i];
+                    ColorTriple c = { qRed(rgb) / 255.0f, qGreen(rgb) / 255.0f, qBlue(rgb) / 255.0f };
+                    if (to == ColorSpaceId::Hsv)
+                        srgbToHsv(c);
+                    else if (to == ColorSpaceId::Hsl)
+                        srgbToHsl(c);
+                    dst[begin + i] = c;
+                }
+                continue;
+            }
+
+            for (int i = 0; i < n; ++i) {
+                const QRgb rgb = src[begin + i];
+                linear[i] = { kDecodeTable.values[qRed(rgb)], kDecodeTable.values[qGreen(rgb)], kDecodeTable.values[qBlue(rgb)] };
+            }
+            fromLinear(linear, to, dst + begin, n);
+        }
+    }
+
+    void ConvertToRgb(ColorSpaceId from, const ColorTriple *src, QRgb *dst, int count, bool *out_of_gamut)
+    {
+        ColorTriple linear[kChunk];
+        for (int begin = 0; begin < count; begin += kChunk) {
+            const int n = std::min(kChunk, count - begin);
+            toLinear(from, src + begin, linear, n);
+            for (int i = 0; i < n; ++i) {
+                const ColorTriple &c = linear[i];
+                if (out_of_gamut) {
+                    out_of_gamut[begin + i] = c.c0 < -kGamutEpsilon || c.c0 > 1 + kGamutEpsilon
+                        || c.c1 < -kGamutEpsilon || c.c1 > 1 + kGamutEpsilon
+                        || c.c2 < -kGamutEpsilon || c.c2 > 1 + kGamutEpsilon;
+                }
+                dst[begin + i] = qRgb(encodeChannel(c.c0), encodeChannel(c.c1), encodeChannel(c.c2));
+            }
+        }
+    }
+
+    QRgb OkLchToRgbInGamut(float L, float C, float hue)
+    {
+        ColorTriple lch = { L, C, hue };
+        QRgb rgb;
+        bool outside = false;
+        ConvertToRgb(ColorSpaceId::OkLch, &lch, &rgb, 1, &outside);
+        if (!outside)
+            return rgb;
+
+        // 二分色度，12次后误差小于色度范围的1/4096
+        float low = 0.0f;
+        float high = C;
+        for (int i = 0; i < 12; ++i) {
+            lch.c1 = (low + high) * 0.5f;
+            ConvertToRgb(ColorSpaceId::OkLch, &lch, &rgb, 1, &outside);
+            if (outside)
+                high = lch.c1;
+            else
+                low = lch.c1;
+        }
+
+        lch.c1 = low;
+        ConvertToRgb(ColorSpaceId::OkLch, &lch, &rgb, 1);
+        return rgb;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QRgb>
+
+namespace Custom_Control
+{
+    // OKLab感知均匀色彩空间，欧氏距离近似人眼的色差
+    struct OkLab
+    {
+        float L;
+        float a;
+        float b;
+    };
+
+    // 8位sRGB通道转线性光强(0~1)，查表实现
+    float SrgbToLinear(int channel);
+
+    // 忽略alpha
+    OkLab RgbToOkLab(QRgb rgb);
+
+    float OkLabDistance(const OkLab &lhs, const OkLab &rhs);
+
+    // 批量转换所支持的色彩空间，三个分量的含义：
+    //   Srgb / LinearRgb  r, g, b                 0~1
+    //   Hsv / Hsl         色相(度, 0~360), s, v/l  0~1
+    //   OkLab             L 0~1, a, b             约±0.4
+    //   OkLch             L 0~1, C 0~约0.37, 色相(度)
+    //   CieLab            L 0~100, a, b           D65白点
+    enum class ColorSpaceId
+    {
+        Srgb,
+        LinearRgb,
+        Hsv,
+        Hsl,
+        OkLab,
+        OkLch,
+        CieLab
+    };
+
+    struct ColorTriple
+    {
+        float c0;
+        float c1;
+        float c2;
+    };
+
+    // 以线性RGB为中转的批量转换，src与dst可以是同一数组
+    // 只有线性RGB与OKLab/OKLch之间的矩阵、立方根与立方运算在x86上走SSE2，HSV、HSL与CIELAB逐项走标量路径
+    // 8位sRGB解码表为编译期常量(constexpr)，编码表在静态初始化时用std::pow生成
+    void ConvertColors(ColorSpaceId from, const ColorTriple *src, ColorSpaceId to, ColorTriple *dst, int count);
+
+    // 8位sRGB输入，忽略alpha
+    void ConvertFromRgb(const QRgb *src, ColorSpaceId to, ColorTriple *dst, int count);
+
+    // 输出不透明的8位sRGB，超出色域的分量被截断；out_of_gamut非空时逐项记录是否超出色域
+    void ConvertToRgb(ColorSpaceId from, const ColorTriple *src, QRgb *dst, int count, bool *out_of_gamut = nullptr);
+
+    // 在保持L与色相的前提下降低色度直到落入sRGB色域
+    QRgb OkLchToRgbInGamut(float L, float C, float hue);
+}
@@ -0,0 +1,154 @@
+#include "NamedColorIndex.h"
+#include "ColorSpace.h"
+#include <QColor>
+#include <QSet>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace Custom_Control
+{
+    namespace
+    {
+        NamedColorIndex &sharedIndex()
+        {
+            static NamedColorIndex index(NamedColorIndex::CssColors());
+            return index;
+        }
+    }
+
+    NamedColorIndex::NamedColorIndex(QVector<NamedColor> colors)
+        : m_colors_(std::move(colors))
+    {
+        m_nodes_.reserve(size_t(m_colors_.size()));
+        for (int i = 0; i < m_colors_.size(); ++i) {
+            const OkLab lab = RgbToOkLab(m_colors_[i].rgb);
+            m_nodes_.push_back({ { lab.L, lab.a, lab.b }, i, 0 });
+        }
+
+        build(0, int(m_nodes_.size()));
+    }
+
+    bool NamedColorIndex::IsEmpty() const
+    {
+        return m_nodes_.empty();
+    }
+
+    int NamedColorIndex::Size() const
+    {
+        return int(m_nodes_.size());
+    }
+
+    void NamedColorIndex::build(int begin, int end)
+    {
+        if (end - begin <= 1)
+            return;
+
+        // 按跨度最大的轴分割，OKLab中L的范围远大于a/b，固定轮换会使树失衡
+        float low[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+        float high[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+        for (int i = begin; i < end; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                low[k] = std::min(low[k], m_nodes_[size_t(i)].coord[k]);
+                high[k] = std::max(high[k], m_nodes_[size_t(i)].coord[k]);
+            }
+        }
+
+        int axis = 0;
+        for (int k = 1; k < 3; ++k) {
+            if (high[k] - low[k] > high[axis] - low[axis])
+                axis = k;
+        }
+
+        const int mid = begin + (end - begin) / 2;
+        std::nth_element(m_nodes_.begin() + begin, m_nodes_.begin() + mid, m_nodes_.begin() + end,
+            [axis](const Node &lhs, const Node &rhs) { return lhs.coord[axis] < rhs.coord[axis]; });
+        m_nodes_[size_t(mid)].axis = axis;
+
+        build(begin, mid);
+        build(mid + 1, end);
+    }
+
+    void NamedColorIndex::search(int begin, int end, const float *query, int &best, float &best_dist2) const
+    {
+        if (begin >= end)
+            return;
+
+        const int mid = begin + (end - begin) / 2;
+        const Node &node = m_nodes_[size_t(mid)];
+
+        const float d0 = node.coord[0] - query[0];
+        const float d1 = node.coord[1] - query[1];
+        const float d2 = node.coord[2] - query[2];
+        const float dist2 = d0 * d0 + d1 * d1 + d2 * d2;
+        if (dist2 < best_dist2) {
+            best_dist2 = dist2;
+            best = node.color;
+        }
+
+        if (end - begin == 1)
+            return;
+
+        // 先搜查询点所在的一侧，另一侧只有分割面比当前最优更近时才需要搜
+        const float diff = query[node.axis] - node.coord[node.axis];
+        if (diff < 0) {
+            search(begin, mid, query, best, best_dist2);
+            if (diff * diff < best_dist2)
+                search(mid + 1, end, query, best, best_dist2);
+        }
+        else {
+            search(mid + 1, end, query, best, best_dist2);
+            if (diff * diff < best_dist2)
+                search(begin, mid, query, best, best_dist2);
+        }
+    }
+
+    const NamedColor *NamedColorIndex::Nearest(QRgb rgb, float *distance) const
+    {
+        if (m_nodes_.empty())
+            return nullptr;
+
+        const OkLab lab = RgbToOkLab(rgb);
+        const float query[3] = { lab.L, lab.a, lab.b };
+        int best = -1;
+        float best_dist2 = std::numeric_limits<float>::max();
+        search(0, int(m_nodes_.size()), query, best, best_dist2);
+
+        if (distance)
+            *distance = std::sqrt(best_dist2);
+
+        return &m_colors_[best];
+    }
+
+    QVector<NamedColor> NamedColorIndex::CssColors()
+    {
+        QVector<NamedColor> colors;
+        QSet<QRgb> seen;
+        const QStringList names = QColor::colorNames();
+        colors.reserve(names.size());
+        for (const QString &name : names) {
+            const QColor color(name);
+            if (!color.isValid() || color.alpha() != 255 || seen.contains(color.rgb()))
+                continue;
+
+            seen.insert(color.rgb());
+            colors.append({ name, color.rgb() });
+        }
+        return colors;
+    }
+
+    const NamedColorIndex &NamedColorIndex::Shared()
+    {
+        return sharedIndex();
+    }
+
+    void NamedColorIndex::SetUserPalette(const QVector<NamedColor> &palette)
+    {
+        QVector<NamedColor> colors = CssColors();
+        colors.reserve(colors.size() + palette.size());
+        for (const NamedColor &color : palette)
+            colors.append(color);
+
+        sharedIndex() = NamedColorIndex(std::move(colors));
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QRgb>
+#include <vector>
+
+namespace Custom_Control
+{
+    struct NamedColor
+    {
+        QString name;
+        QRgb rgb;
+    };
+
+    // 命名颜色的最近邻索引：在OKLab空间上建k-d树，数万条目的查询也只需数微秒
+    class NamedColorIndex
+    {
+    public:
+        NamedColorIndex() = default;
+        explicit NamedColorIndex(QVector<NamedColor> colors);
+
+        bool IsEmpty() const;
+        int Size() const;
+
+        // 返回OKLab距离最近的命名颜色，索引为空时返回nullptr；忽略alpha
+        const NamedColor *Nearest(QRgb rgb, float *distance = nullptr) const;
+
+        // CSS/SVG颜色名，同色的别名(gray/grey等)只保留一个
+        static QVector<NamedColor> CssColors();
+
+        // 进程内共享的索引：CSS颜色名加上可选的用户色板，只在GUI线程使用
+        static const NamedColorIndex &Shared();
+        static void SetUserPalette(const QVector<NamedColor> &palette);
+
+    private:
+        struct Node
+        {
+            float coord[3];
+            int color;
+            int axis;
+        };
+
+        void build(int begin, int end);
+        void search(int begin, int end, const float *query, int &best, float &best_dist2) const;
+
+    private:
+        QVector<NamedColor> m_colors_;
+        // 隐式k-d树：区间[begin, end)的中点为分割节点，左右子区间即两棵子树
+        std::vector<Node> m_nodes_;
+    };
+}
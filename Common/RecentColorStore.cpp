@@ -0,0 +1,240 @@
+#include "RecentColorStore.h"
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDir>
+#include <QPointer>
+
+namespace Custom_Control
+{
+    namespace
+    {
+        // 文件布局（均为64位字）：
+        //   [0] 魔数与版本  [1] 下一个序号  [2..3] 保留
+        //   [4 .. 4+kCapacity)              环形条目：(序号低32位 << 32) | rgba，0为空或已删除
+        //   [.. +kBucketCount)              去重哈希桶：rgba最新一条条目的副本
+        const quint64 kMagic = 0x5243435300000001ull;
+        const int kHeaderWords = 4;
+        const int kTotalWords = kHeaderWords + RecentColorStore::kCapacity + RecentColorStore::kBucketCount;
+
+        static_assert((RecentColorStore::kCapacity & (RecentColorStore::kCapacity - 1)) == 0,
+            "capacity must be a power of two");
+        static_assert(RecentColorStore::kBucketCount > RecentColorStore::kCapacity,
+            "buckets must outnumber live entries");
+
+        // 映射文件上的原子操作要跨进程生效，须为无锁实现且与原始64位字布局一致
+#if defined(__cpp_lib_atomic_is_always_lock_free)
+        constexpr bool kSharedAtomics = std::atomic<quint64>::is_always_lock_free
+            && sizeof(std::atomic<quint64>) == sizeof(quint64);
+#else
+        constexpr bool kSharedAtomics = ATOMIC_LLONG_LOCK_FREE == 2
+            && sizeof(std::atomic<quint64>) == sizeof(quint64);
+#endif
+
+        // 主要平台上必须满足，其余平台不满足时只使用进程内缓冲
+#if defined(Q_PROCESSOR_X86_64) || defined(Q_PROCESSOR_ARM_64)
+        static_assert(kSharedAtomics, "std::atomic<quint64> must be lock-free to share the mapped file");
+#endif
+
+        // 序号低32位作为条目标签，容量为2的幂，回绕后槽位仍一致
+        quint32 entryTag(quint64 seq)
+        {
+            return quint32(seq + 1);
+        }
+
+        quint64 makeEntry(quint64 seq, QRgb rgba)
+        {
+            return (quint64(entryTag(seq)) << 32) | rgba;
+        }
+
+        int entrySlot(quint64 entry)
+        {
+            return int((entry >> 32) & (RecentColorStore::kCapacity - 1));
+        }
+
+        QRgb entryColor(quint64 entry)
+        {
+            return QRgb(entry & 0xFFFFFFFFu);
+        }
+
+        int bucketOf(QRgb rgba)
+        {
+            quint32 h = rgba * 0x9E3779B1u;
+            return int((h >> 16) % RecentColorStore::kBucketCount);
+        }
+    }
+
+    RecentColorStore *RecentColorStore::Instance()
+    {
+        static QPointer<RecentColorStore> store;
+        if (!store) {
+            const QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+                + QStringLiteral("/custom_control");
+            store = new RecentColorStore(dir + QStringLiteral("/recent_colors.bin"));
+            QObject::connect(qApp, &QCoreApplication::aboutToQuit, store.data(), [] {
+                delete store.data();
+                });
+        }
+        return store;
+    }
+
+    RecentColorStore::RecentColorStore(const QString &file_path, QObject *parent)
+        : QObject(parent)
+    {
+        if (!attach(file_path)) {
+            m_private_words_.reset(new std::atomic<quint64>[kTotalWords]);
+            for (int i = 0; i < kTotalWords; ++i)
+                m_private_words_[i].store(0, std::memory_order_relaxed);
+            m_private_words_[0].store(kMagic);
+            attachMemory(m_private_words_.get());
+        }
+    }
+
+    RecentColorStore::~RecentColorStore()
+    {
+
+    }
+
+    bool RecentColorStore::IsShared() const
+    {
+        return !m_private_words_;
+    }
+
+    bool RecentColorStore::attach(const QString &file_path)
+    {
+        if (!kSharedAtomics)
+            return false;
+
+        if (file_path.isEmpty() || !QDir().mkpath(QFileInfo(file_path).absolutePath()))
+            return false;
+
+        m_file_.setFileName(file_path);
+        if (!m_file_.open(QIODevice::ReadWrite))
+            return false;
+
+        // 多个进程同时创建时都扩展到相同大小，新增部分为0
+        const qint64 size = qint64(kTotalWords) * qint64(sizeof(quint64));
+        if (m_file_.size() < size && !m_file_.resize(size)) {
+            m_file_.close();
+            return false;
+        }
+
+        uchar *data = m_file_.map(0, size);
+        if (!data) {
+            m_file_.close();
+            return false;
+        }
+
+        // 全0的新文件由第一个进程写入魔数；布局版本不符的文件不去改动
+        auto magic = reinterpret_cast<std::atomic<quint64> *>(data);
+        quint64 expected = 0;
+        if (!magic->compare_exchange_strong(expected, kMagic) && expected != kMagic) {
+            m_file_.unmap(data);
+            m_file_.close();
+            return false;
+        }
+
+        attachMemory(magic);
+        return true;
+    }
+
+    void RecentColorStore::attachMemory(std::atomic<quint64> *words)
+    {
+        m_next_seq_ = words + 1;
+        m_entries_ = words + kHeaderWords;
+        m_buckets_ = m_entries_ + kCapacity;
+    }
+
+    void RecentColorStore::Append(const QColor &color)
+    {
+        if (!color.isValid())
+            return;
+
+        const quint64 seq = m_next_seq_->fetch_add(1);
+        const quint64 entry = makeEntry(seq, color.rgba());
+        m_entries_[entrySlot(entry)].store(entry);
+        updateBucket(entry);
+
+        emit sig_changed();
+    }
+
+    void RecentColorStore::updateBucket(quint64 entry)
+    {
+        const QRgb rgba = entryColor(entry);
+
+        // 线性探测：找到同色的桶则替换并删除旧条目，否则占用链上第一个失效的桶或链尾的空桶
+        // 桶永不清空，探测链不会断开；与其他进程竞争失败时重新探测
+        for (;;) {
+            int index = bucketOf(rgba);
+            int reusable = -1;
+            quint64 reusable_bucket = 0;
+            bool retry = false;
+            int probe = 0;
+            for (; probe < kBucketCount; ++probe, index = (index + 1) % kBucketCount) {
+                quint64 bucket = m_buckets_[index].load();
+                if (bucket == 0)
+                    break;
+
+                if (entryColor(bucket) == rgba) {
+                    if (!m_buckets_[index].compare_exchange_strong(bucket, entry)) {
+                        retry = true;
+                        break;
+                    }
+
+                    // 旧条目仍在环中时清为0；已被覆盖则比较失败，不受影响
+                    m_entries_[entrySlot(bucket)].compare_exchange_strong(bucket, 0);
+                    return;
+                }
+
+                if (reusable < 0 && m_entries_[entrySlot(bucket)].load() != bucket) {
+                    reusable = index;
+                    reusable_bucket = bucket;
+                }
+            }
+
+            if (retry)
+                continue;
+
+            if (reusable >= 0) {
+                if (m_buckets_[reusable].compare_exchange_strong(reusable_bucket, entry))
+                    return;
+                continue;
+            }
+
+            // 桶数大于容量，链上总有失效或空的桶，这里只会是空桶
+            if (probe == kBucketCount)
+                return;
+
+            quint64 empty = 0;
+            if (m_buckets_[index].compare_exchange_strong(empty, entry))
+                return;
+        }
+    }
+
+    QVector<QColor> RecentColorStore::Colors(int max) const
+    {
+        QVector<QColor> colors;
+        if (max < 0 || max > kCapacity)
+            max = kCapacity;
+
+        colors.reserve(max);
+
+        // 从最新的序号往回读，标签不符说明槽位已被删除、覆盖或尚未写完
+        const quint64 end = m_next_seq_->load();
+        for (quint64 k = 0; k < quint64(kCapacity) && k < end && colors.size() < max; ++k) {
+            const quint64 seq = end - 1 - k;
+            const quint64 entry = m_entries_[entryTag(seq) & (kCapacity - 1)].load();
+            if (quint32(entry >> 32) != entryTag(seq))
+                continue;
+
+            colors.append(QColor::fromRgba(entryColor(entry)));
+        }
+
+        return colors;
+    }
+
+    quint64 RecentColorStore::Sequence() const
+    {
+        return m_next_seq_->load();
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QObject>
+#include <QColor>
+#include <QFile>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+namespace Custom_Control
+{
+    // 最近使用的颜色，保存在固定大小的内存映射环形文件中，多个进程共享同一份历史
+    // 文件内容即内存布局，打开后无需解析；追加与去重只用原子操作，不加锁
+    class RecentColorStore : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        // 环形缓冲容量须为2的幂，哈希桶数大于容量以保证总有可用的桶
+        static const int kCapacity = 64;
+        static const int kBucketCount = 128;
+
+        // 进程内共享实例，文件位于GenericDataLocation/custom_control下
+        static RecentColorStore *Instance();
+
+        // 文件无法映射或64位原子操作不是无锁实现时，退化为仅本进程可见的内存缓冲
+        explicit RecentColorStore(const QString &file_path, QObject *parent = nullptr);
+        ~RecentColorStore() override;
+
+        bool IsShared() const;
+
+        // 同一颜色只保留最新的一条
+        void Append(const QColor &color);
+
+        // 从新到旧排列，max小于0时返回全部
+        QVector<QColor> Colors(int max = -1) const;
+
+        // 每次追加都会递增，包括其他进程的追加，可用来低成本地判断历史是否变化
+        quint64 Sequence() const;
+
+    signals:
+        void sig_changed();
+
+    private:
+        bool attach(const QString &file_path);
+        void attachMemory(std::atomic<quint64> *words);
+        void updateBucket(quint64 entry);
+
+    private:
+        QFile m_file_;
+        std::unique_ptr<std::atomic<quint64>[]> m_private_words_;
+
+        std::atomic<quint64> *m_next_seq_ { nullptr };
+        std::atomic<quint64> *m_entries_ { nullptr };
+        std::atomic<quint64> *m_buckets_ { nullptr };
+    };
+}
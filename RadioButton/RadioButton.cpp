@@ -1,9 +1,57 @@
 #include "RadioButton.h"
 
 #include <QPainter>
+#include <QPixmap>
+#include <QCache>
 
 namespace Custom_Control
 {
+    namespace
+    {
+        // Rendered states are shared by every RadioButton; 4 MB holds far more styles than a form uses.
+        const int kStateCacheCost = 4 * 1024;
+
+        struct StateKey
+        {
+            QSize size;
+            QRgb background;
+            QRgb foreground;
+            QRgb border;
+            int thickness;
+            int radius;
+            int dpr;
+            bool checked;
+
+            bool operator==(const StateKey &other) const
+            {
+                return size == other.size && background == other.background && foreground == other.foreground
+                    && border == other.border && thickness == other.thickness && radius == other.radius
+                    && dpr == other.dpr && checked == other.checked;
+            }
+        };
+
+#if QT_VERSION < QT_VERSION_CHECK(6,0,0)
+        uint qHash(const StateKey &key, uint seed = 0)
+#else
+        size_t qHash(const StateKey &key, size_t seed = 0)
+#endif
+        {
+            const quint64 geometry = (quint64(key.size.width() & 0xFFFF) << 48) | (quint64(key.size.height() & 0xFFFF) << 32)
+                | (quint64(key.thickness & 0xFF) << 24) | (quint64(key.radius & 0xFF) << 16)
+                | (quint64(key.dpr & 0x7FFF) << 1) | quint64(key.checked);
+
+            return ::qHash((quint64(key.background) << 32) | key.foreground, seed)
+                ^ (::qHash(key.border, seed) * 31)
+                ^ (::qHash(geometry, seed) * 131);
+        }
+
+        QCache<StateKey, QPixmap> &stateCache()
+        {
+            static QCache<StateKey, QPixmap> cache(kStateCacheCost);
+            return cache;
+        }
+    }
+
     RadioButton::RadioButton(QWidget *parent) :QRadioButton(parent)
     {
 
@@ -16,7 +64,11 @@ namespace Custom_Control
 
     void RadioButton::SetBackgroundColor(const QColor &color)
     {
+        if (m_background_color_ == color)
+            return;
+
         m_background_color_ = color;
+        update();
     }
 
     QColor RadioButton::GetBackgroundColor()
@@ -26,7 +78,11 @@ namespace Custom_Control
 
     void RadioButton::SetForegroundColor(QColor &color)
     {
+        if (m_foreground_color_ == color)
+            return;
+
         m_foreground_color_ = color;
+        update();
     }
 
     QColor RadioButton::GetForegroundColor()
@@ -36,7 +92,11 @@ namespace Custom_Control
 
     void RadioButton::SetBorderColor(QColor &color)
     {
+        if (m_border_color_ == color)
+            return;
+
         m_border_color_ = color;
+        update();
     }
 
     QColor RadioButton::GetBorderColor()
@@ -46,7 +106,11 @@ namespace Custom_Control
 
     void RadioButton::SetThickness(int thickness)
     {
+        if (m_thickness_ == thickness)
+            return;
+
         m_thickness_ = thickness;
+        update();
     }
 
     int RadioButton::GetThickness() const
@@ -56,7 +120,11 @@ namespace Custom_Control
 
     void RadioButton::SetRadius(int radius)
     {
+        if (m_border_radius_ == radius)
+            return;
+
         m_border_radius_ = radius;
+        update();
     }
 
     int RadioButton::GetRadius() const
@@ -67,12 +135,42 @@ namespace Custom_Control
     void RadioButton::paintEvent(QPaintEvent *event)
     {
         Q_UNUSED(event);
+        if (this->size().isEmpty())
+            return;
+
+        // Every button with the same style, size and state blits the same pixmap.
+        const qreal dpr = devicePixelRatioF();
+        const StateKey key { this->size(), m_background_color_.rgba(), m_foreground_color_.rgba(), m_border_color_.rgba(),
+            m_thickness_, m_border_radius_, qRound(dpr * 100), this->isChecked() };
+
         QPainter painter(this);
+        QCache<StateKey, QPixmap> &cache = stateCache();
+        if (const QPixmap *cached = cache.object(key)) {
+            painter.drawPixmap(0, 0, *cached);
+            return;
+        }
+
+        // A pixmap bigger than the whole cache would be rejected, paint it without caching.
+        const QPixmap pixmap = renderState(dpr);
+        const int cost = qMax(1, int(qint64(pixmap.width()) * pixmap.height() * 4 / 1024));
+        if (cost <= cache.maxCost())
+            cache.insert(key, new QPixmap(pixmap), cost);
+
+        painter.drawPixmap(0, 0, pixmap);
+    }
+
+    QPixmap RadioButton::renderState(qreal dpr) const
+    {
+        QPixmap pixmap(this->size() * dpr);
+        pixmap.setDevicePixelRatio(dpr);
+        pixmap.fill(Qt::transparent);
+
+        QPainter painter(&pixmap);
         painter.setRenderHint(QPainter::Antialiasing);
 
         // TODO:Style control through files
         painter.setBrush(m_background_color_);
-        
+
         // hide border
         painter.drawRoundedRect(0, 0, this->width(), this->height(), m_border_radius_, m_border_radius_);
 
@@ -88,6 +186,7 @@ namespace Custom_Control
             painter.drawPolyline(p, 3);
         }
 
+        return pixmap;
     }
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QRadioButton>
+#include <QPixmap>
 #include "Logger.h"
 
 namespace Custom_Control
@@ -28,8 +29,13 @@ namespace Custom_Control
         int GetRadius() const;
 
     protected:
+        // Blits a pixmap shared by all instances with the same size, colours, thickness,
+        // radius, DPR and check state; only a new combination is rendered.
         void paintEvent(QPaintEvent *event) override;
 
+    private:
+        QPixmap renderState(qreal dpr) const;
+
     private:
         QColor m_background_color_ { "#000000" };
         QColor m_foreground_color_ { "#FFFFFF" };
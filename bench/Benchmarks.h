@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QJsonObject>
+
+// Microbenchmarks reported next to the per-DPR widget runs. The plane and parser benchmarks
+// run in the driver; the sampler benchmark needs a real X display and runs in a child.
+
+// Fills SV planes with each kernel the CPU supports and reports megapixels per second.
+QJsonObject BenchPlaneKernels(int iterations);
+
+// Parses a batch of theme colour strings with ParseColor and with the old regex-based
+// colorFromStr, and reports the time per string for both.
+QJsonObject BenchColorParser(int iterations);
+
+// Grabs ColorSpy-sized blocks from the primary screen with grabWindow and with the default
+// thread-safe backend (XShm, GDI) when there is one, and reports samples per second and
+// client CPU time per sample.
+QJsonObject BenchScreenSamplers(int iterations);
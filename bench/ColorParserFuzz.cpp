@@ -0,0 +1,38 @@
+// libFuzzer entry point for ParseColor. Build with -DCUSTOM_CONTROL_FUZZ=ON and clang.
+// The input is tried both as UTF-8 and as raw UTF-16; a failed parse must report an
+// error position inside the input, a successful one a valid colour.
+
+#include "ColorParser.h"
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace Custom_Control;
+
+namespace
+{
+    void check(QStringView text)
+    {
+        for (HexAlphaOrder order : { HexAlphaOrder::Last, HexAlphaOrder::First }) {
+            const ColorParseResult result = ParseColor(text, order);
+            if (result.IsValid()) {
+                if (!result.color.isValid())
+                    std::abort();
+            }
+            else if (result.error_pos < 0 || result.error_pos > text.size()) {
+                std::abort();
+            }
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    const QString utf8 = QString::fromUtf8(reinterpret_cast<const char *>(data), int(size));
+    check(utf8);
+
+    const QString utf16 = QString::fromUtf16(reinterpret_cast<const char16_t *>(data), int(size / 2));
+    check(utf16);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Pins ParseColor behaviour that theme imports depend on, in particular the alpha position
+// of 4- and 8-digit hex colours. Returns non-zero on the first mismatch.
+
+#include "ColorParser.h"
+#include <cstdio>
+
+using namespace Custom_Control;
+
+namespace
+{
+    int g_failures = 0;
+
+    void expectColor(const char *text, HexAlphaOrder order, const QColor &expected)
+    {
+        const ColorParseResult result = ParseColor(QString::fromLatin1(text), order);
+        if (!result.IsValid() || result.color.rgba() != expected.rgba()) {
+            std::fprintf(stderr, "FAIL %s (%s): got %s, expected %s\n", text,
+                order == HexAlphaOrder::First ? "First" : "Last",
+                qPrintable(result.color.name(QColor::HexArgb)), qPrintable(expected.name(QColor::HexArgb)));
+            ++g_failures;
+        }
+    }
+
+    void expectError(const char *text, ColorParseError error, int pos)
+    {
+        const ColorParseResult result = ParseColor(QString::fromLatin1(text));
+        if (result.error != error || result.error_pos != pos) {
+            std::fprintf(stderr, "FAIL %s: got error %d at %d, expected %d at %d\n", text,
+                int(result.error), result.error_pos, int(error), pos);
+            ++g_failures;
+        }
+    }
+}
+
+int main()
+{
+    // CSS order is the default: alpha last.
+    expectColor("#11223344", HexAlphaOrder::Last, QColor(0x11, 0x22, 0x33, 0x44));
+    expectColor("#1234", HexAlphaOrder::Last, QColor(0x11, 0x22, 0x33, 0x44));
+
+    // Qt order, as written by QColor::name(QColor::HexArgb) and read by the old colorFromStr.
+    expectColor("#11223344", HexAlphaOrder::First, QColor(0x22, 0x33, 0x44, 0x11));
+    expectColor("#1234", HexAlphaOrder::First, QColor(0x22, 0x33, 0x44, 0x11));
+    expectColor("#80ff0000", HexAlphaOrder::First, QColor::fromRgba(0x80ff0000u));
+    {
+        const QColor qt_color(0x12, 0x34, 0x56, 0x78);
+        expectColor(qPrintable(qt_color.name(QColor::HexArgb)), HexAlphaOrder::First, qt_color);
+    }
+
+    // Without alpha the order does not matter.
+    expectColor("#abc", HexAlphaOrder::First, QColor(0xaa, 0xbb, 0xcc));
+    expectColor("#a1b2c3", HexAlphaOrder::First, QColor(0xa1, 0xb2, 0xc3));
+    expectColor("#a1b2c3", HexAlphaOrder::Last, QColor(0xa1, 0xb2, 0xc3));
+
+    expectColor("rgba(61, 174, 233, 128)", HexAlphaOrder::Last, QColor(61, 174, 233, 128));
+    expectColor("rgba(0, 0, 0, 0.5)", HexAlphaOrder::Last, QColor(0, 0, 0, 128));
+    expectColor("steelblue", HexAlphaOrder::Last, QColor(70, 130, 180));
+
+    expectError("#12345", ColorParseError::InvalidHexLength, 0);
+    expectError("#12g", ColorParseError::UnexpectedCharacter, 3);
+    expectError("  ", ColorParseError::Empty, 2);
+
+    if (g_failures == 0)
+        std::printf("color_parser_test: all checks passed\n");
+    return g_failures == 0 ? 0 : 1;
+}
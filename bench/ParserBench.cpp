@@ -0,0 +1,99 @@
+#include "Benchmarks.h"
+#include "ColorParser.h"
+#include <QColor>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
+
+using namespace Custom_Control;
+
+namespace
+{
+    // The regex-based parser that ColorWorkbench used before ParseColor, kept as the baseline.
+    QColor legacyColorFromStr(QString str)
+    {
+        QColor color(str);
+        if (!color.isValid()) {
+            QString tmpStr = str;
+            QRegularExpression rx("[^\\d+^,^.]");
+            if (str.contains(rx)) {
+                tmpStr.remove(rx);
+            }
+            if (!tmpStr.isEmpty()) {
+                QStringList strList = tmpStr.split(",");
+                if (str.contains("rgba") && strList.count() == 4) {
+                    color.setRgb(strList.at(0).toInt(), strList.at(1).toInt(), strList.at(2).toInt());
+                    if (strList.at(3).toDouble() > 1) {
+                        color.setAlpha(strList.at(3).toInt());
+                    }
+                    else {
+                        color.setAlphaF(strList.at(3).toDouble());
+                    }
+                }
+                else if (str.contains("rgb") && strList.count() == 3) {
+                    color.setRgb(strList.at(0).toInt(), strList.at(1).toInt(), strList.at(2).toInt());
+                }
+                else if (str.contains("hsv") && strList.count() == 3) {
+                    color.setHsv(strList.at(0).toInt(), strList.at(1).toInt(), strList.at(2).toInt());
+                }
+            }
+        }
+
+        return color;
+    }
+
+    // A theme import: the formats a style sheet or settings file typically stores.
+    QVector<QString> themeStrings()
+    {
+        return {
+            QStringLiteral("#1e1e1e"), QStringLiteral("#ffffff"), QStringLiteral("#3daee9"),
+            QStringLiteral("#80000000"), QStringLiteral("#ff2a82da"), QStringLiteral("#fff"),
+            QStringLiteral("rgb(35, 38, 41)"), QStringLiteral("rgb(239,240,241)"),
+            QStringLiteral("rgba(0, 0, 0, 0.5)"), QStringLiteral("rgba(61, 174, 233, 128)"),
+            QStringLiteral("rgba(255, 255, 255, 0.08)"), QStringLiteral("hsv(204, 188, 233)"),
+            QStringLiteral("white"), QStringLiteral("transparent"), QStringLiteral("darkgray"),
+            QStringLiteral("steelblue"), QStringLiteral("#2d2d2d"), QStringLiteral("rgb(127, 140, 141)")
+        };
+    }
+}
+
+QJsonObject BenchColorParser(int iterations)
+{
+    const QVector<QString> strings = themeStrings();
+
+    // Results are accumulated so the calls cannot be optimised away.
+    quint32 checksum = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        for (const QString &text : strings)
+            checksum += ParseColor(text, HexAlphaOrder::First).color.rgba();
+    }
+    const qint64 parse_ns = timer.nsecsElapsed();
+
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        for (const QString &text : strings)
+            checksum += legacyColorFromStr(text).rgba();
+    }
+    const qint64 legacy_ns = timer.nsecsElapsed();
+
+    // With the Qt alpha order both parsers must read every theme string the same way.
+    int agreeing = 0;
+    for (const QString &text : strings) {
+        if (ParseColor(text, HexAlphaOrder::First).color.rgba() == legacyColorFromStr(text).rgba())
+            ++agreeing;
+    }
+
+    const double count = double(strings.size()) * iterations;
+    QJsonObject report;
+    report.insert(QStringLiteral("strings"), strings.size());
+    report.insert(QStringLiteral("parse_color_ns_per_string"), parse_ns / count);
+    report.insert(QStringLiteral("legacy_ns_per_string"), legacy_ns / count);
+    report.insert(QStringLiteral("speedup"), parse_ns > 0 ? double(legacy_ns) / parse_ns : 0.0);
+    report.insert(QStringLiteral("agreeing_strings"), agreeing);
+    report.insert(QStringLiteral("checksum"), double(checksum));
+    return report;
+}
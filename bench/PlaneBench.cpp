@@ -0,0 +1,69 @@
+#include "Benchmarks.h"
+#include "ColorPlane.h"
+#include <QElapsedTimer>
+#include <QImage>
+#include <QJsonArray>
+
+using namespace Custom_Control;
+
+namespace
+{
+    struct KernelCase
+    {
+        PlaneKernel kernel;
+        const char *name;
+    };
+
+    const KernelCase kKernels[] = {
+        { PlaneKernel::Scalar, "Scalar" },
+        { PlaneKernel::SSE2, "SSE2" },
+        { PlaneKernel::AVX2, "AVX2" }
+    };
+
+    // The default ColorSVCanvas size, its 2x backing store and a large plane.
+    const QSize kPlaneSizes[] = { QSize(300, 180), QSize(600, 360), QSize(1024, 1024) };
+}
+
+QJsonObject BenchPlaneKernels(int iterations)
+{
+    QJsonArray results;
+    for (const QSize &size : kPlaneSizes) {
+        QImage reference(size, QImage::Format_ARGB32_Premultiplied);
+        FillSVPlane(reference, 200, PlaneKernel::Scalar);
+
+        for (const KernelCase &kernel_case : kKernels) {
+            QJsonObject result;
+            result.insert(QStringLiteral("kernel"), QString::fromLatin1(kernel_case.name));
+            result.insert(QStringLiteral("width"), size.width());
+            result.insert(QStringLiteral("height"), size.height());
+            if (!IsPlaneKernelSupported(kernel_case.kernel)) {
+                result.insert(QStringLiteral("supported"), false);
+                results.append(result);
+                continue;
+            }
+
+            QImage image(size, QImage::Format_ARGB32_Premultiplied);
+            FillSVPlane(image, 200, kernel_case.kernel);
+            const bool matches = image == reference;
+
+            // Cycle the hue so every sector's coefficient set is exercised.
+            QElapsedTimer timer;
+            timer.start();
+            for (int i = 0; i < iterations; ++i)
+                FillSVPlane(image, (i * 7) % 360, kernel_case.kernel);
+            const qint64 elapsed = timer.nsecsElapsed();
+
+            const double pixels = double(size.width()) * size.height() * iterations;
+            result.insert(QStringLiteral("supported"), true);
+            result.insert(QStringLiteral("matches_scalar"), matches);
+            result.insert(QStringLiteral("ns_per_plane"), double(elapsed) / iterations);
+            result.insert(QStringLiteral("megapixels_per_second"), elapsed > 0 ? pixels * 1e3 / elapsed : 0.0);
+            results.append(result);
+        }
+    }
+
+    QJsonObject report;
+    report.insert(QStringLiteral("active"), QString::fromLatin1(kKernels[int(ActivePlaneKernel())].name));
+    report.insert(QStringLiteral("results"), results);
+    return report;
+}
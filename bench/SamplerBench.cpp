@@ -0,0 +1,82 @@
+#include "Benchmarks.h"
+#include "ScreenSampler.h"
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QScreen>
+#include <cstring>
+#include <ctime>
+#include <memory>
+
+using namespace Custom_Control;
+
+namespace
+{
+    // The ColorSpy capture block (11 px loupe plus a 16 px margin per side) and a larger region.
+    const int kBlockSizes[] = { 43, 256 };
+
+    QJsonObject benchSampler(ScreenSampler &sampler, const ScreenTarget &screen, int block, int iterations)
+    {
+        const QRect bounds = screen.geometry.adjusted(0, 0, -block, -block);
+
+        // Walk the block across the screen, as a moving cursor would.
+        int grabbed = 0;
+        const std::clock_t cpu_start = std::clock();
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < iterations; ++i) {
+            const QPoint pos(bounds.left() + (i * 37) % qMax(1, bounds.width()),
+                bounds.top() + (i * 23) % qMax(1, bounds.height()));
+            if (!sampler.Grab(screen, QRect(pos, QSize(block, block))).isNull())
+                ++grabbed;
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+        const double cpu_seconds = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+        QJsonObject result;
+        result.insert(QStringLiteral("backend"), QString::fromLatin1(sampler.Name()));
+        result.insert(QStringLiteral("block"), block);
+        result.insert(QStringLiteral("grabs"), iterations);
+        result.insert(QStringLiteral("non_null"), grabbed);
+        result.insert(QStringLiteral("samples_per_second"), elapsed > 0 ? iterations * 1e9 / elapsed : 0.0);
+        result.insert(QStringLiteral("thread_safe"), sampler.IsThreadSafe());
+        // Client-side CPU only; the X server's share of an XShm or GetImage request is not included.
+        result.insert(QStringLiteral("cpu_us_per_sample"), cpu_seconds * 1e6 / iterations);
+        return result;
+    }
+}
+
+QJsonObject BenchScreenSamplers(int iterations)
+{
+    QJsonObject report;
+    report.insert(QStringLiteral("platform"), QGuiApplication::platformName());
+
+    QScreen *primary = QGuiApplication::primaryScreen();
+    if (!primary) {
+        report.insert(QStringLiteral("error"), QStringLiteral("no screen"));
+        return report;
+    }
+    const ScreenTarget screen = ScreenTarget::FromScreen(primary);
+    report.insert(QStringLiteral("screen_width"), screen.geometry.width());
+    report.insert(QStringLiteral("screen_height"), screen.geometry.height());
+    report.insert(QStringLiteral("screen_dpr"), screen.device_pixel_ratio);
+
+    // grabWindow against whatever CreateScreenSampler() picks (XShm on xcb, GDI on Windows).
+    std::vector<std::unique_ptr<ScreenSampler>> samplers;
+    samplers.emplace_back(new GrabWindowSampler());
+    std::unique_ptr<ScreenSampler> native = CreateScreenSampler();
+    report.insert(QStringLiteral("default_backend"), QString::fromLatin1(native->Name()));
+    report.insert(QStringLiteral("xshm_available"), std::strcmp(native->Name(), "xshm") == 0);
+    if (native->IsThreadSafe())
+        samplers.push_back(std::move(native));
+
+    QJsonArray results;
+    for (const std::unique_ptr<ScreenSampler> &sampler : samplers) {
+        for (int block : kBlockSizes) {
+            benchSampler(*sampler, screen, block, qMax(1, iterations / 10));
+            results.append(benchSampler(*sampler, screen, block, iterations));
+        }
+    }
+    report.insert(QStringLiteral("results"), results);
+    return report;
+}
@@ -0,0 +1,521 @@
+// Headless benchmark for the Custom_Control widgets.
+//
+// The driver process starts one child per device pixel ratio on the offscreen QPA platform
+// (QT_SCALE_FACTOR selects the ratio, which cannot change inside a running QApplication) and
+// merges the children's results into a single JSON document on stdout or --output. The
+// microbenchmarks that need no widgets run in the driver itself.
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QScreen>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+#include "Benchmarks.h"
+#include "ColorPalette.h"
+#include "ColorPlane.h"
+#include "ColorSpy.h"
+#include "RadioButton.h"
+
+using namespace Custom_Control;
+
+namespace
+{
+    const char *kChildFlag = "--child";
+    const int kDefaultIterations = 200;
+    const int kFirstPaintRuns = 10;
+    const int kHeapInstances = 16;
+    const int kSizeScales[] = { 1, 2, 4 };
+
+    struct WidgetCase
+    {
+        QString name;
+        QSize base_size;
+        std::function<QWidget *()> create;
+        // Extra counters from the widget's own instrumentation, read after the steady-state paints.
+        std::function<void(QWidget *, QJsonObject &)> counters;
+    };
+
+    std::vector<WidgetCase> widgetCases()
+    {
+        std::vector<WidgetCase> cases;
+        cases.push_back({ QStringLiteral("ColorSVCanvas"), QSize(300, 180),
+            [] { return new ColorSVCanvas(); },
+            [](QWidget *widget, QJsonObject &counters) {
+                counters.insert(QStringLiteral("last_paint_pixels"),
+                    double(static_cast<ColorSVCanvas *>(widget)->LastPaintPixels()));
+            } });
+        cases.push_back({ QStringLiteral("ColorHueBar"), QSize(230, 16),
+            [] { return new ColorHueBar(); }, nullptr });
+        cases.push_back({ QStringLiteral("ColorAlphaBar"), QSize(230, 16),
+            [] { return new ColorAlphaBar(); }, nullptr });
+        cases.push_back({ QStringLiteral("ColorChecker"), QSize(32, 32),
+            [] { return new ColorChecker(); }, nullptr });
+        cases.push_back({ QStringLiteral("ColorWorkbench"), QSize(320, 304),
+            [] { return new ColorWorkbench(); },
+            [](QWidget *widget, QJsonObject &counters) {
+                counters.insert(QStringLiteral("model_notifications"),
+                    double(static_cast<ColorWorkbench *>(widget)->Model()->NotificationCount()));
+            } });
+        cases.push_back({ QStringLiteral("ColorPalette"), QSize(40, 40),
+            [] { return new ColorPalette(); }, nullptr });
+        cases.push_back({ QStringLiteral("ColorSpy"), QSize(),
+            [] { return new ColorSpy(); }, nullptr });
+        cases.push_back({ QStringLiteral("RadioButton"), QSize(16, 16),
+            [] {
+                RadioButton *button = new RadioButton();
+                button->setChecked(true);
+                return button;
+            }, nullptr });
+        return cases;
+    }
+
+    // Bytes currently allocated through malloc, or -1 where the C library does not report it.
+    qint64 heapInUse()
+    {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        return qint64(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+        return qint64(mallinfo().uordblks);
+#else
+        return -1;
+#endif
+    }
+
+    // Resident set size in bytes, or -1 where /proc is not available.
+    qint64 residentSetSize()
+    {
+        QFile statm(QStringLiteral("/proc/self/statm"));
+        if (!statm.open(QIODevice::ReadOnly))
+            return -1;
+
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() < 2)
+            return -1;
+#if defined(Q_OS_UNIX)
+        return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+        return -1;
+#endif
+    }
+
+    qint64 percentile(std::vector<qint64> samples, double fraction)
+    {
+        if (samples.empty())
+            return 0;
+
+        const size_t index = std::min(samples.size() - 1, size_t(fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+
+    void destroy(QWidget *widget)
+    {
+        delete widget;
+        // Several controls release children with deleteLater().
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+
+    // Lays the widget out at the requested size without putting it on a screen. Events are not
+    // processed, so the window system never paints it and the first render() is the first paint.
+    void prepare(QWidget *widget, const QSize &size)
+    {
+        widget->setAttribute(Qt::WA_DontShowOnScreen);
+        if (size.isValid())
+            widget->resize(size);
+        widget->show();
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::LayoutRequest);
+    }
+
+    QImage renderTarget(QWidget *widget)
+    {
+        const qreal dpr = widget->devicePixelRatioF();
+        QImage target(widget->size() * dpr, QImage::Format_ARGB32_Premultiplied);
+        target.setDevicePixelRatio(dpr);
+        target.fill(Qt::transparent);
+        return target;
+    }
+
+    qint64 timeRender(QWidget *widget, QImage &target)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        widget->render(&target);
+        return timer.nsecsElapsed();
+    }
+
+    QJsonObject measure(const WidgetCase &widget_case, const QSize &size, int iterations)
+    {
+        QJsonObject result;
+        result.insert(QStringLiteral("widget"), widget_case.name);
+
+        // Construction alone, without layout or paint.
+        std::vector<qint64> construct;
+        for (int i = 0; i < std::max(1, iterations / 4); ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            QWidget *widget = widget_case.create();
+            construct.push_back(timer.nsecsElapsed());
+            destroy(widget);
+        }
+
+        // First paint of a fresh instance. Process-wide caches are warm after the first run.
+        std::vector<qint64> first_paint;
+        for (int i = 0; i < kFirstPaintRuns; ++i) {
+            QWidget *widget = widget_case.create();
+            prepare(widget, size);
+            QImage target = renderTarget(widget);
+            first_paint.push_back(timeRender(widget, target));
+            destroy(widget);
+        }
+
+        // Steady-state repaint of one instance.
+        QWidget *widget = widget_case.create();
+        prepare(widget, size);
+        QImage target = renderTarget(widget);
+        timeRender(widget, target);
+        std::vector<qint64> paint;
+        for (int i = 0; i < iterations; ++i)
+            paint.push_back(timeRender(widget, target));
+
+        result.insert(QStringLiteral("width"), widget->width());
+        result.insert(QStringLiteral("height"), widget->height());
+        result.insert(QStringLiteral("dpr"), widget->devicePixelRatioF());
+
+        QJsonObject counters;
+        if (widget_case.counters)
+            widget_case.counters(widget, counters);
+        destroy(widget);
+
+        // Heap held by live, laid-out and painted instances, averaged over several of them.
+        const qint64 heap_before = heapInUse();
+        std::vector<QWidget *> instances;
+        for (int i = 0; i < kHeapInstances; ++i) {
+            QWidget *instance = widget_case.create();
+            prepare(instance, size);
+            QImage instance_target = renderTarget(instance);
+            instance->render(&instance_target);
+            instances.push_back(instance);
+        }
+        const qint64 heap_after = heapInUse();
+        for (QWidget *instance : instances)
+            destroy(instance);
+
+        result.insert(QStringLiteral("construct_ns_median"), double(percentile(construct, 0.5)));
+        result.insert(QStringLiteral("first_paint_ns_median"), double(percentile(first_paint, 0.5)));
+        result.insert(QStringLiteral("paint_ns_median"), double(percentile(paint, 0.5)));
+        result.insert(QStringLiteral("paint_ns_p90"), double(percentile(paint, 0.9)));
+        if (heap_before < 0)
+            result.insert(QStringLiteral("heap_bytes_per_instance"), QJsonValue());
+        else
+            result.insert(QStringLiteral("heap_bytes_per_instance"), double(heap_after - heap_before) / kHeapInstances);
+        if (!counters.isEmpty())
+            result.insert(QStringLiteral("counters"), counters);
+
+        return result;
+    }
+
+    // Counts paint events delivered to a widget by the window system.
+    class PaintCounter : public QObject
+    {
+    public:
+        int Count() const
+        {
+            return m_count_;
+        }
+
+    protected:
+        bool eventFilter(QObject *watched, QEvent *event) override
+        {
+            if (event->type() == QEvent::Paint)
+                ++m_count_;
+            return QObject::eventFilter(watched, event);
+        }
+
+    private:
+        int m_count_ { 0 };
+    };
+
+    // Moves the SV ring on a shown canvas and lets the backing store repaint it, so the
+    // incremental path (old and new ring areas only) runs instead of a full render().
+    QJsonObject measureRingMoves(int iterations)
+    {
+        ColorSVCanvas canvas;
+        canvas.resize(300, 180);
+        canvas.SetHue(200);
+        canvas.show();
+        QCoreApplication::processEvents();
+
+        PaintCounter counter;
+        canvas.installEventFilter(&counter);
+
+        const QRect plane = canvas.AvailabilityRect();
+        const qreal dpr = canvas.devicePixelRatioF();
+        const qint64 full_pixels = qRound64(plane.width() * plane.height() * dpr * dpr);
+
+        std::vector<qint64> pass_ns;
+        std::vector<qint64> pixels;
+        for (int i = 0; i < iterations; ++i) {
+            // Small diagonal steps, as during a drag.
+            const int step = i % 64;
+            canvas.SetSaturationValue(64 + step * 2, 192 - step);
+
+            const int painted = counter.Count();
+            QElapsedTimer deadline;
+            deadline.start();
+            while (counter.Count() == painted && deadline.elapsed() < 100) {
+                QElapsedTimer timer;
+                timer.start();
+                QCoreApplication::processEvents();
+                if (counter.Count() != painted) {
+                    pass_ns.push_back(timer.nsecsElapsed());
+                    pixels.push_back(canvas.LastPaintPixels());
+                }
+            }
+        }
+
+        QJsonObject result;
+        result.insert(QStringLiteral("moves"), iterations);
+        result.insert(QStringLiteral("repaints"), int(pixels.size()));
+        result.insert(QStringLiteral("full_plane_pixels"), double(full_pixels));
+        result.insert(QStringLiteral("paint_pixels_median"), double(percentile(pixels, 0.5)));
+        result.insert(QStringLiteral("paint_pixels_max"), double(percentile(pixels, 1.0)));
+        // Event-loop pass that delivered the repaint, including the backing store flush.
+        result.insert(QStringLiteral("repaint_pass_ns_median"), double(percentile(pass_ns, 0.5)));
+        return result;
+    }
+
+    const int kPaletteCount = 300;
+
+    // Builds kPaletteCount palettes in one window. "eager" reproduces the construction before the
+    // shared workbench: every palette owned a hidden ColorWorkbench built in its constructor.
+    // Each path runs in its own process so freed memory from one does not hide the other's RSS.
+    QJsonObject measurePalettes(const QString &path)
+    {
+        const bool eager = path == QLatin1String("eager");
+
+        // Warm process-wide state (fonts, style, caches) so it is not billed to the palettes.
+        {
+            QWidget warm;
+            ColorPalette palette(&warm);
+            if (eager)
+                new ColorWorkbench(&palette);
+        }
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+        QWidget *host = new QWidget();
+        const qint64 rss_before = residentSetSize();
+        const qint64 heap_before = heapInUse();
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < kPaletteCount; ++i) {
+            ColorPalette *palette = new ColorPalette(host);
+            if (eager)
+                new ColorWorkbench(palette);
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+
+        const qint64 heap_after = heapInUse();
+        const qint64 rss_after = residentSetSize();
+        destroy(host);
+
+        QJsonObject result;
+        result.insert(QStringLiteral("path"), path);
+        result.insert(QStringLiteral("palettes"), kPaletteCount);
+        result.insert(QStringLiteral("construct_ms"), elapsed / 1e6);
+        result.insert(QStringLiteral("heap_bytes"), heap_before < 0 ? QJsonValue() : QJsonValue(double(heap_after - heap_before)));
+        result.insert(QStringLiteral("rss_bytes"), rss_before < 0 ? QJsonValue() : QJsonValue(double(rss_after - rss_before)));
+        return result;
+    }
+
+    void writeCompact(const QJsonObject &object)
+    {
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+    }
+
+    int runChild(int argc, char *argv[])
+    {
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+
+        QApplication app(argc, argv);
+
+        QCommandLineParser parser;
+        parser.addOption(QCommandLineOption(QStringLiteral("child")));
+        parser.addOption(QCommandLineOption(QStringLiteral("iterations"), QString(), QStringLiteral("n"),
+            QString::number(kDefaultIterations)));
+        parser.addOption(QCommandLineOption(QStringLiteral("palettes"), QString(), QStringLiteral("path")));
+        parser.addOption(QCommandLineOption(QStringLiteral("samplers")));
+        parser.process(app);
+
+        if (parser.isSet(QStringLiteral("samplers"))) {
+            writeCompact(BenchScreenSamplers(std::max(1, parser.value(QStringLiteral("iterations")).toInt())));
+            return 0;
+        }
+
+        if (parser.isSet(QStringLiteral("palettes"))) {
+            writeCompact(measurePalettes(parser.value(QStringLiteral("palettes"))));
+            return 0;
+        }
+
+        const int iterations = std::max(1, parser.value(QStringLiteral("iterations")).toInt());
+
+        QJsonArray results;
+        for (const WidgetCase &widget_case : widgetCases()) {
+            QSize previous;
+            for (int scale : kSizeScales) {
+                // Fixed-size controls report the same size at every scale; measure them once.
+                QWidget *probe = widget_case.create();
+                prepare(probe, widget_case.base_size.isValid() ? widget_case.base_size * scale : QSize());
+                const QSize size = probe->size();
+                destroy(probe);
+                if (size == previous)
+                    continue;
+
+                previous = size;
+                results.append(measure(widget_case, size, iterations));
+            }
+        }
+
+        QJsonObject run;
+        run.insert(QStringLiteral("requested_scale_factor"), QString::fromLocal8Bit(qgetenv("QT_SCALE_FACTOR")));
+        run.insert(QStringLiteral("screen_dpr"), QGuiApplication::primaryScreen() ? QGuiApplication::primaryScreen()->devicePixelRatio() : 1.0);
+        run.insert(QStringLiteral("results"), results);
+        run.insert(QStringLiteral("ring_moves"), measureRingMoves(iterations));
+
+        writeCompact(run);
+        return 0;
+    }
+
+    // Runs this executable in child mode and returns its JSON report, or an object holding
+    // "error" when the child fails.
+    QJsonObject runChildProcess(const QStringList &arguments, const QProcessEnvironment &env)
+    {
+        QProcess child;
+        child.setProcessEnvironment(env);
+        child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        child.start(QCoreApplication::applicationFilePath(), QStringList { QString::fromLatin1(kChildFlag) } + arguments);
+        child.waitForFinished(-1);
+
+        QJsonParseError error;
+        const QJsonDocument doc = QJsonDocument::fromJson(child.readAllStandardOutput(), &error);
+        if (child.exitStatus() != QProcess::NormalExit || child.exitCode() != 0 || !doc.isObject()) {
+            QJsonObject failed;
+            failed.insert(QStringLiteral("error"), error.error != QJsonParseError::NoError
+                ? error.errorString() : QStringLiteral("child exited with code %1").arg(child.exitCode()));
+            return failed;
+        }
+        return doc.object();
+    }
+
+    int runDriver(int argc, char *argv[])
+    {
+        QCoreApplication app(argc, argv);
+
+        QCommandLineParser parser;
+        parser.setApplicationDescription(QStringLiteral("Headless benchmark for the Custom_Control widgets."));
+        parser.addHelpOption();
+        parser.addOption(QCommandLineOption(QStringLiteral("dpr"), QStringLiteral("Comma-separated device pixel ratios."),
+            QStringLiteral("list"), QStringLiteral("1,1.5,2")));
+        parser.addOption(QCommandLineOption(QStringLiteral("iterations"), QStringLiteral("Steady-state paints per measurement."),
+            QStringLiteral("n"), QString::number(kDefaultIterations)));
+        parser.addOption(QCommandLineOption(QStringLiteral("output"),
+            QStringLiteral("Write the JSON report to a file instead of stdout."), QStringLiteral("file")));
+        parser.addOption(QCommandLineOption(QStringLiteral("samplers"),
+            QStringLiteral("Also benchmark the screen samplers on the native display (on X11 e.g. under xvfb-run).")));
+        parser.process(app);
+
+        QJsonArray runs;
+        int exit_code = 0;
+        for (const QString &dpr : parser.value(QStringLiteral("dpr")).split(QLatin1Char(','))) {
+            QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+            env.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("offscreen"));
+            env.insert(QStringLiteral("QT_SCALE_FACTOR"), dpr.trimmed());
+
+            QJsonObject run = runChildProcess({ QStringLiteral("--iterations"), parser.value(QStringLiteral("iterations")) }, env);
+            if (run.contains(QStringLiteral("error"))) {
+                run.insert(QStringLiteral("requested_scale_factor"), dpr.trimmed());
+                exit_code = 1;
+            }
+            runs.append(run);
+        }
+
+        // Shared workbench against one workbench per palette, each in a fresh process.
+        QProcessEnvironment palette_env = QProcessEnvironment::systemEnvironment();
+        palette_env.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("offscreen"));
+        palette_env.remove(QStringLiteral("QT_SCALE_FACTOR"));
+        QJsonArray palettes;
+        for (const QString &path : { QStringLiteral("shared"), QStringLiteral("eager") }) {
+            const QJsonObject result = runChildProcess({ QStringLiteral("--palettes"), path }, palette_env);
+            if (result.contains(QStringLiteral("error")))
+                exit_code = 1;
+            palettes.append(result);
+        }
+
+        // Screen capture needs a real display, so it runs on the native platform instead of offscreen.
+        QJsonObject samplers;
+        if (parser.isSet(QStringLiteral("samplers"))) {
+            QProcessEnvironment sampler_env = QProcessEnvironment::systemEnvironment();
+            sampler_env.remove(QStringLiteral("QT_QPA_PLATFORM"));
+            sampler_env.remove(QStringLiteral("QT_SCALE_FACTOR"));
+            samplers = runChildProcess({ QStringLiteral("--samplers"), QStringLiteral("--iterations"),
+                QString::number(std::max(1, parser.value(QStringLiteral("iterations")).toInt()) * 10) }, sampler_env);
+            if (samplers.contains(QStringLiteral("error")))
+                exit_code = 1;
+        }
+
+        QJsonObject report;
+        report.insert(QStringLiteral("qt_version"), QString::fromLatin1(qVersion()));
+        report.insert(QStringLiteral("platform"), QStringLiteral("offscreen"));
+        report.insert(QStringLiteral("iterations"), parser.value(QStringLiteral("iterations")).toInt());
+        report.insert(QStringLiteral("runs"), runs);
+        report.insert(QStringLiteral("palette_construction"), palettes);
+        const int micro_iterations = std::max(1, parser.value(QStringLiteral("iterations")).toInt());
+        report.insert(QStringLiteral("plane_kernels"), BenchPlaneKernels(micro_iterations));
+        report.insert(QStringLiteral("color_parser"), BenchColorParser(micro_iterations * 50));
+        if (!samplers.isEmpty())
+            report.insert(QStringLiteral("screen_samplers"), samplers);
+        const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+        if (parser.isSet(QStringLiteral("output"))) {
+            QFile file(parser.value(QStringLiteral("output")));
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+                return 2;
+            file.write(json);
+        }
+        else {
+            QFile out;
+            out.open(stdout, QIODevice::WriteOnly);
+            out.write(json);
+        }
+        return exit_code;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], kChildFlag) == 0)
+            return runChild(argc, argv);
+    }
+    return runDriver(argc, argv);
+}